@@ -2,9 +2,11 @@
 
 #include "byte_stream.hh"
 #include "eventloop.hh"
+#include "mapped_file.hh"
 
 #include <algorithm>
 #include <iostream>
+#include <optional>
 #include <unistd.h>
 
 using namespace std;
@@ -16,7 +18,17 @@ void bidirectional_stream_copy( Socket& socket )
   EventLoop _eventloop {};
   FileDescriptor _input { STDIN_FILENO };
   FileDescriptor _output { STDOUT_FILENO };
-  ByteStream _outbound { buffer_size };
+
+  // A regular file on stdin is mapped rather than read: the outbound stream holds slices of the
+  // mapping, which are written to the socket straight from the page cache. (That saves the copies
+  // only up to the socket: a TCPMinnowSocket's thread reads the bytes from its socketpair into
+  // the TCPPeer's own pages, as it does any other input.)
+  optional<MappedFile> _input_file {};
+  if ( MappedFile::mappable( _input ) ) {
+    _input_file.emplace( _input );
+  }
+
+  ByteStream _outbound { buffer_size, _input_file ? ByteStream::Storage::Chunked : ByteStream::Storage::Ring };
   ByteStream _inbound { buffer_size };
   bool _outbound_shutdown { false };
   bool _inbound_shutdown { false };
@@ -25,25 +37,40 @@ void bidirectional_stream_copy( Socket& socket )
   _input.set_blocking( false );
   _output.set_blocking( false );
 
-  // rule 1: read from stdin into outbound byte stream
-  _eventloop.add_rule(
-    "read from stdin into outbound byte stream",
-    _input,
-    Direction::In,
-    [&] {
-      string data;
-      data.resize( _outbound.writer().available_capacity() );
-      _input.read( data );
-      _outbound.writer().push( move( data ) );
-      if ( _input.eof() ) {
-        _outbound.writer().close();
-      }
-    },
-    [&] {
-      return ( not _outbound.reader().has_error() ) and ( _outbound.writer().available_capacity() > 0 )
-             and ( not _inbound.reader().has_error() );
-    },
-    [&] { _outbound.writer().close(); } );
+  if ( _input_file ) {
+    // rule 1: push slices of the mapped stdin into outbound byte stream
+    _eventloop.add_rule(
+      "push mapped stdin into outbound byte stream",
+      [&] {
+        Writer& outbound = _outbound.writer();
+        outbound.push( _input_file->slice( outbound.bytes_pushed(), outbound.available_capacity() ) );
+        if ( outbound.bytes_pushed() == _input_file->size() ) {
+          outbound.close();
+        }
+      },
+      [&] {
+        return ( not _outbound.writer().is_closed() ) and ( not _outbound.reader().has_error() )
+               and ( _outbound.writer().available_capacity() > 0 ) and ( not _inbound.reader().has_error() );
+      } );
+  } else {
+    // rule 1: read from stdin into outbound byte stream
+    _eventloop.add_rule(
+      "read from stdin into outbound byte stream",
+      _input,
+      Direction::In,
+      [&] {
+        Writer& outbound = _outbound.writer();
+        outbound.commit( _input.read( outbound.reserve( outbound.available_capacity() ) ) );
+        if ( _input.eof() ) {
+          _outbound.writer().close();
+        }
+      },
+      [&] {
+        return ( not _outbound.reader().has_error() ) and ( _outbound.writer().available_capacity() > 0 )
+               and ( not _inbound.reader().has_error() );
+      },
+      [&] { _outbound.writer().close(); } );
+  }
 
   // rule 2: read from outbound byte stream into socket
   _eventloop.add_rule(
@@ -52,7 +79,7 @@ void bidirectional_stream_copy( Socket& socket )
     Direction::Out,
     [&] {
       if ( _outbound.reader().bytes_buffered() ) {
-        _outbound.reader().pop( socket.write( _outbound.reader().peek() ) );
+        _outbound.reader().pop( socket.write( _outbound.reader().peek_all() ) );
       }
       if ( _outbound.reader().is_finished() ) {
         socket.shutdown( SHUT_WR );
@@ -70,10 +97,8 @@ void bidirectional_stream_copy( Socket& socket )
     socket,
     Direction::In,
     [&] {
-      string data;
-      data.resize( _inbound.writer().available_capacity() );
-      socket.read( data );
-      _inbound.writer().push( move( data ) );
+      Writer& inbound = _inbound.writer();
+      inbound.commit( socket.read( inbound.reserve( inbound.available_capacity() ) ) );
       if ( socket.eof() ) {
         _inbound.writer().close();
       }
@@ -91,7 +116,7 @@ void bidirectional_stream_copy( Socket& socket )
     Direction::Out,
     [&] {
       if ( _inbound.reader().bytes_buffered() ) {
-        _inbound.reader().pop( _output.write( _inbound.reader().peek() ) );
+        _inbound.reader().pop( _output.write( _inbound.reader().peek_all() ) );
       }
       if ( _inbound.reader().is_finished() ) {
         _output.close();
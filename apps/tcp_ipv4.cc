@@ -16,6 +16,7 @@ using namespace std;
 
 constexpr const char* TUN_DFLT = "tun144";
 constexpr const char* LOCAL_ADDRESS_DFLT = "169.254.144.9";
+constexpr long MSS_MAX = 65495; // the largest IPv4 datagram, less the IP and TCP headers
 
 static void show_usage( const char* argv0, const char* msg )
 {
@@ -34,8 +35,14 @@ static void show_usage( const char* argv0, const char* msg )
 
        << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
 
+       << "   -m <mss>        Send and accept segments of up to <mss> bytes   " << TCPConfig::MAX_PAYLOAD_SIZE
+       << "\n"
+       << "                   (payload and TCP options; 1.." << MSS_MAX << ")\n\n"
+
        << "   -d <tundev>     Connect to tun <tundev>                         " << TUN_DFLT << "\n\n"
 
+       << "   -b              Hold out-of-order data in a bitmap and ring     (ordered map)\n\n"
+
        << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
        << "   -Ld <loss>      Set downlink loss to <rate> (float in 0..1)     (no loss)\n\n"
 
@@ -93,6 +100,21 @@ static tuple<TCPConfig, FdAdapterConfig, bool, const char*> get_config( const sp
       c_fsm.rt_timeout = strtol( args[curr + 1], nullptr, 0 );
       curr += 2;
 
+    } else if ( strncmp( "-m", args[curr], 3 ) == 0 ) {
+      check_argc( args, curr, "ERROR: -m requires one argument." );
+      char* end = nullptr;
+      const long mss = strtol( args[curr + 1], &end, 0 );
+      if ( *args[curr + 1] == '\0' or *end != '\0' or mss < 1 or mss > MSS_MAX ) {
+        show_usage( args[0], ( "ERROR: -m requires a number from 1 to " + to_string( MSS_MAX ) + "." ).c_str() );
+        exit( 1 );
+      }
+      c_fsm.mss = static_cast<uint16_t>( mss );
+      curr += 2;
+
+    } else if ( strncmp( "-b", args[curr], 3 ) == 0 ) {
+      c_fsm.reassembler_engine = Reassembler::Engine::Bitmap;
+      curr += 1;
+
     } else if ( strncmp( "-d", args[curr], 3 ) == 0 ) {
       check_argc( args, curr, "ERROR: -t requires one argument." );
       tundev = args[curr + 1];
@@ -23,6 +23,9 @@ ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(byte_stream_spsc)
+ttest(byte_stream_paged)
+ttest(byte_stream_watermarks)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -31,6 +34,8 @@ ttest(reassembler_dup)
 ttest(reassembler_holes)
 ttest(reassembler_overlapping)
 ttest(reassembler_win)
+ttest(reassembler_engines)
+ttest(reassembler_limits)
 
 ttest(wrapping_integers_cmp)
 ttest(wrapping_integers_wrap)
@@ -45,6 +50,7 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_sack)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,6 +59,18 @@ ttest(send_window)
 ttest(send_ack)
 ttest(send_close)
 ttest(send_extra)
+ttest(send_sack)
+ttest(send_congestion)
+ttest(send_rtt)
+ttest(send_fast_retransmit)
+ttest(send_zero_copy)
+ttest(send_mss)
+ttest(send_window_scale)
+ttest(recv_window_scale)
+ttest(send_timestamps)
+ttest(recv_timestamps)
+
+ttest(tcp_segment_options)
 
 ttest(net_interface)
 
@@ -64,7 +82,7 @@ add_custom_target (check1 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --s
 
 add_custom_target (check2 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 20 -R '^byte_stream_|^reassembler_|^wrapping|^recv')
 
-add_custom_target (check3 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 20 -R '^byte_stream_|^reassembler_|^wrapping|^recv|^send')
+add_custom_target (check3 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 20 -R '^byte_stream_|^reassembler_|^wrapping|^recv|^send|^tcp_segment_options')
 
 add_custom_target (check4 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 20 -R '^net_interface')
 
@@ -74,6 +92,8 @@ add_custom_target (check5 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --s
 
 add_custom_target (speed COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --timeout 20 -R '_speed_test')
 
+add_custom_target (benchmark COMMAND byte_stream_benchmark DEPENDS byte_stream_benchmark)
+
 set(compile_name_opt "compile with optimization")
 add_test(NAME ${compile_name_opt}
   COMMAND "${CMAKE_COMMAND}" --build "${CMAKE_BINARY_DIR}" -t speed_testing)
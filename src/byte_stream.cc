@@ -5,7 +5,28 @@
 
 using namespace std;
 
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ) {}
+static variant<RingStorage, ChunkedStorage, MirroredStorage, PagedStorage> make_storage(
+  uint64_t capacity,
+  ByteStream::Storage storage )
+{
+  switch ( storage ) {
+    case ByteStream::Storage::Chunked:
+      return ChunkedStorage {};
+    case ByteStream::Storage::Mirrored:
+      return MirroredStorage { capacity };
+    case ByteStream::Storage::Paged:
+      return PagedStorage {};
+    case ByteStream::Storage::Ring:
+      break;
+  }
+  return RingStorage { capacity };
+}
+
+ByteStream::ByteStream( uint64_t capacity, Storage storage )
+  : _storage( make_storage( capacity, storage ) ), capacity_( capacity )
+{
+  update_readiness_();
+}
 
 void Writer::push( string data )
 {
@@ -15,18 +36,62 @@ void Writer::push( string data )
     data.erase( available );
   }
 
+  reserved_ = 0;
   bytes_write_ += data.size();
   stream_push_( data );
+  update_readiness_();
+}
+
+void Writer::push( Buffer data )
+{
+  const uint64_t available = available_capacity();
+
+  if ( data.size() > available ) {
+    data = data.substr( 0, available );
+  }
+
+  reserved_ = 0;
+  bytes_write_ += data.size();
+  stream_push_( data );
+  update_readiness_();
+}
+
+vector<span<char>> Writer::reserve( uint64_t len )
+{
+  vector<span<char>> spans;
+  reserve( len, spans );
+  return spans;
+}
+
+void Writer::reserve( uint64_t len, vector<span<char>>& spans )
+{
+  spans.clear();
+  reserved_ = std::min( len, available_capacity() );
+  stream_reserve_( reserved_, spans );
+}
+
+void Writer::commit( uint64_t len )
+{
+  if ( len > reserved_ ) {
+    throw runtime_error( "Writer::commit() beyond the reserved space" );
+  }
+
+  reserved_ = 0;
+  bytes_write_ += len;
+  stream_commit_( len );
+  update_readiness_();
 }
 
 void Writer::close()
 {
   closed_ = true;
+  update_readiness_();
 }
 
 void Writer::set_error()
 {
   errored_ = true;
+  update_readiness_();
 }
 
 bool Writer::is_closed() const
@@ -34,9 +99,14 @@ bool Writer::is_closed() const
   return closed_;
 }
 
+uint64_t Writer::capacity() const
+{
+  return capacity_;
+}
+
 uint64_t Writer::available_capacity() const
 {
-  return capacity_ - stream_buffered_();
+  return std::min( capacity_ - stream_buffered_() - retained_, stream_headroom_() );
 }
 
 uint64_t Writer::bytes_pushed() const
@@ -44,11 +114,34 @@ uint64_t Writer::bytes_pushed() const
   return bytes_write_;
 }
 
+void Writer::set_watermarks( uint64_t low, uint64_t high )
+{
+  write_low_ = std::max<uint64_t>( low, 1 );
+  write_high_ = std::max( write_low_, std::min( high, capacity_ ) );
+  writable_ = false; // re-evaluate against the new thresholds
+  update_readiness_();
+}
+
+bool Writer::is_ready() const
+{
+  return not closed_ and not errored_ and available_capacity() >= write_threshold_();
+}
+
 string_view Reader::peek() const
 {
   return stream_peek_();
 }
 
+vector<string_view> Reader::peek_all() const
+{
+  return stream_peek_all_();
+}
+
+optional<Buffer> Reader::peek_buffer() const
+{
+  return stream_peek_buffer_();
+}
+
 bool Reader::is_finished() const
 {
   return closed_ && stream_is_empty_();
@@ -65,6 +158,26 @@ void Reader::pop( uint64_t len )
 
   stream_pop_( _len );
   bytes_read_ += _len;
+  if ( retain_popped_ ) {
+    retained_ += _len;
+  }
+  update_readiness_();
+}
+
+void Reader::retain_popped( bool retain )
+{
+  retain_popped_ = retain;
+}
+
+void Reader::release( uint64_t len )
+{
+  retained_ -= std::min( retained_, len );
+  update_readiness_();
+}
+
+uint64_t Reader::bytes_retained() const
+{
+  return retained_;
 }
 
 uint64_t Reader::bytes_buffered() const
@@ -77,27 +190,87 @@ uint64_t Reader::bytes_popped() const
   return bytes_read_;
 }
 
+void Reader::set_watermarks( uint64_t low, uint64_t high )
+{
+  read_low_ = std::max<uint64_t>( low, 1 );
+  read_high_ = std::max( read_low_, std::min( high, capacity_ ) );
+  readable_ = false; // re-evaluate against the new thresholds
+  update_readiness_();
+}
+
+bool Reader::is_ready() const
+{
+  return readable_;
+}
+
+void ByteStream::update_readiness_()
+{
+  const uint64_t available = closed_ or errored_ ? 0 : writer().available_capacity();
+  writable_ = available >= write_threshold_();
+  readable_ = closed_ or errored_ or stream_buffered_() >= ( readable_ ? read_low_ : read_high_ );
+}
+
+uint64_t ByteStream::write_threshold_() const
+{
+  if ( writable_ or stream_buffered_() + retained_ == 0 ) {
+    return write_low_;
+  }
+  return write_high_;
+}
+
 bool ByteStream::stream_is_empty_() const
 {
-  return _stream.empty();
+  return stream_buffered_() == 0;
 }
 
 uint64_t ByteStream::stream_buffered_() const
 {
-  return _stream.size();
+  return std::visit( []( const auto& storage ) { return storage.size(); }, _storage );
+}
+
+uint64_t ByteStream::stream_headroom_() const
+{
+  return std::visit( []( const auto& storage ) { return storage.headroom(); }, _storage );
 }
 
 void ByteStream::stream_push_( std::string& data )
 {
-  _stream.append( data );
+  std::visit( [&data]( auto& storage ) { storage.push( data ); }, _storage );
+}
+
+void ByteStream::stream_push_( Buffer& data )
+{
+  std::visit( [&data]( auto& storage ) { storage.push( std::move( data ) ); }, _storage );
 }
 
 void ByteStream::stream_pop_( uint64_t len )
 {
-  _stream.erase( 0, len );
+  std::visit( [len]( auto& storage ) { storage.pop( len ); }, _storage );
 }
 
 std::string_view ByteStream::stream_peek_() const
 {
-  return std::string_view { _stream };
+  return std::visit( []( const auto& storage ) { return storage.peek(); }, _storage );
+}
+
+std::optional<Buffer> ByteStream::stream_peek_buffer_() const
+{
+  return std::visit( []( const auto& storage ) { return storage.peek_buffer(); }, _storage );
+}
+
+std::vector<std::string_view> ByteStream::stream_peek_all_() const
+{
+  std::vector<std::string_view> views;
+  std::visit( [&views]( const auto& storage ) { storage.peek_all( views ); }, _storage );
+  return views;
+}
+
+void ByteStream::stream_reserve_( uint64_t len, std::vector<std::span<char>>& spans )
+{
+  std::visit( [&]( auto& storage ) { storage.reserve( len, spans ); }, _storage );
+}
+
+void ByteStream::stream_commit_( uint64_t len )
+{
+  std::visit( [len]( auto& storage ) { storage.commit( len ); }, _storage );
 }
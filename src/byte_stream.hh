@@ -1,17 +1,33 @@
 #pragma once
 
+#include "byte_stream_storage.hh"
+
+#include <optional>
 #include <queue>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <variant>
+#include <vector>
 
 class Reader;
 class Writer;
 
 class ByteStream
 {
+public:
+  // How the stream stores its buffered bytes
+  enum class Storage
+  {
+    Ring,     // fixed-capacity ring buffer allocated once (default)
+    Chunked,  // queue of the pushed strings: pushes are moved in, never copied
+    Mirrored, // ring buffer mapped twice in virtual memory: peek always returns every buffered byte
+    Paged,    // pages from the process-wide BufferPool: memory follows the bytes buffered, within a budget
+  };
+
 private:
-  std::string _stream = {};
+  std::variant<RingStorage, ChunkedStorage, MirroredStorage, PagedStorage> _storage;
 
 protected:
   uint64_t capacity_;
@@ -20,16 +36,33 @@ protected:
   bool errored_ = {};
   uint64_t bytes_write_ = {};
   uint64_t bytes_read_ = {};
+  uint64_t reserved_ = {};
+  bool retain_popped_ = {};
+  uint64_t retained_ = {}; // popped, but still counted against the capacity (see Reader::retain_popped)
+
+  // Readiness thresholds and states (see Writer::set_watermarks and Reader::set_watermarks)
+  uint64_t write_low_ = 1, write_high_ = 1;
+  uint64_t read_low_ = 1, read_high_ = 1;
+  bool writable_ = {};
+  bool readable_ = {};
+  uint64_t write_threshold_() const; // the room the writer needs to be ready
+  void update_readiness_();          // after any change
 
   // Helper functions of stream data
   bool stream_is_empty_() const;
   uint64_t stream_buffered_() const;
+  uint64_t stream_headroom_() const;
   void stream_push_( std::string& data );
+  void stream_push_( Buffer& data );
   void stream_pop_( uint64_t len );
   std::string_view stream_peek_() const;
+  std::optional<Buffer> stream_peek_buffer_() const;
+  std::vector<std::string_view> stream_peek_all_() const;
+  void stream_reserve_( uint64_t len, std::vector<std::span<char>>& spans );
+  void stream_commit_( uint64_t len );
 
 public:
-  explicit ByteStream( uint64_t capacity );
+  explicit ByteStream( uint64_t capacity, Storage storage = Storage::Ring );
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -42,13 +75,32 @@ class Writer : public ByteStream
 {
 public:
   void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
+  void push( Buffer data );      // Same, but chunked storage shares data's storage rather than copying it.
+
+  // Zero-copy alternative to push: `reserve` returns writable spans inside the stream's own storage
+  // (as much of `len` as the available capacity allows), and `commit` publishes the first `len` bytes
+  // written to them. A later push or reserve discards any reservation that was not committed; the reader
+  // popping bytes, even all of them, leaves it in place.
+  std::vector<std::span<char>> reserve( uint64_t len );
+  void reserve( uint64_t len, std::vector<std::span<char>>& spans ); // the same, into a vector kept for reuse
+  void commit( uint64_t len );
 
   void close();     // Signal that the stream has reached its ending. Nothing more will be written.
   void set_error(); // Signal that the stream suffered an error.
 
   bool is_closed() const;              // Has the stream been closed?
+  uint64_t capacity() const;           // How many bytes can the stream hold in all?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
+                                       // (Paged storage: also limited by the BufferPool's budget)
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
+
+  // Readiness: the writer becomes ready once available_capacity() reaches `high`, and stays ready until it
+  // drops below `low` (by default both are 1, i.e. ready whenever there is room), so a bulk writer can wait
+  // for a worthwhile amount of room. But with nothing buffered or retained, no pop or release will make
+  // more room, so then `low` is enough. (Paged storage can also lose room to other streams' use of the
+  // pool; is_ready() looks at the room there is now.)
+  void set_watermarks( uint64_t low, uint64_t high );
+  bool is_ready() const;
 };
 
 class Reader : public ByteStream
@@ -57,11 +109,30 @@ public:
   std::string_view peek() const; // Peek at the next bytes in the buffer
   void pop( uint64_t len );      // Remove `len` bytes from the buffer
 
+  // Peek at every buffered byte, one view per stored region (e.g. for a vectored write)
+  std::vector<std::string_view> peek_all() const;
+
+  // Peek at the next bytes as a Buffer that shares the stream's storage, if the storage allows it
+  std::optional<Buffer> peek_buffer() const;
+
   bool is_finished() const; // Is the stream finished (closed and fully popped)?
   bool has_error() const;   // Has the stream had an error?
 
   uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
   uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
+
+  // Unacknowledged-region mode: popped bytes go on counting against the capacity until released (e.g. by
+  // a TCPSender once they are acknowledged), so what the writer has handed over stays within the capacity
+  // even while the reader's slices of it are still in use. (Those are slices of the storage only where
+  // read() can share it, i.e. Paged and Chunked storage; others hand out copies.)
+  void retain_popped( bool retain );
+  void release( uint64_t len );    // Release the first `len` retained bytes (at most all of them)
+  uint64_t bytes_retained() const; // Popped, and not yet released
+
+  // Readiness: the reader becomes ready once bytes_buffered() reaches `high` (or the stream is closed or
+  // has an error), and stays ready until it drops below `low` (by default both are 1).
+  void set_watermarks( uint64_t low, uint64_t high );
+  bool is_ready() const;
 };
 
 /*
@@ -69,3 +140,9 @@ public:
  * from a ByteStream Reader into a string;
  */
 void read( Reader& reader, uint64_t len, std::string& out );
+
+/*
+ * read: the same, into a Buffer. When the storage can share its bytes and the next `len`
+ * bytes are stored together, `out` is a slice of the stream's storage instead of a copy.
+ */
+void read( Reader& reader, uint64_t len, Buffer& out );
@@ -1,5 +1,6 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
 #include <cstdint>
 #include <stdexcept>
 
@@ -24,6 +25,20 @@ void read( Reader& reader, uint64_t len, std::string& out )
   }
 }
 
+void read( Reader& reader, uint64_t len, Buffer& out )
+{
+  const auto front = reader.peek_buffer();
+  if ( front.has_value() and front->size() >= std::min( len, reader.bytes_buffered() ) ) {
+    out = front->substr( 0, len );
+    reader.pop( out.size() );
+    return;
+  }
+
+  std::string copied;
+  read( reader, len, copied );
+  out = std::move( copied );
+}
+
 Reader& ByteStream::reader()
 {
   static_assert( sizeof( Reader ) == sizeof( ByteStream ),
@@ -0,0 +1,360 @@
+#include "byte_stream_storage.hh"
+#include "exception.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+void RingStorage::push( string_view data )
+{
+  reserving_ = false;
+  if ( data.empty() ) {
+    return;
+  }
+
+  const uint64_t tail = ( head_ + size_ ) % ring_.size();
+  const uint64_t first = min( data.size(), ring_.size() - tail );
+
+  copy_n( data.data(), first, ring_.data() + tail );
+  copy_n( data.data() + first, data.size() - first, ring_.data() );
+  size_ += data.size();
+}
+
+void RingStorage::pop( uint64_t len )
+{
+  size_ -= len;
+
+  // rewind an empty ring so the next peek sees as many contiguous bytes as possible (unless that would
+  // move a reservation)
+  if ( size_ == 0 and not reserving_ ) {
+    head_ = 0;
+  } else {
+    head_ = ( head_ + len ) % ring_.size();
+  }
+}
+
+string_view RingStorage::peek() const
+{
+  return { ring_.data() + head_, min( size_, ring_.size() - head_ ) };
+}
+
+void RingStorage::peek_all( vector<string_view>& out ) const
+{
+  const string_view first = peek();
+  if ( not first.empty() ) {
+    out.push_back( first );
+  }
+  if ( first.size() < size_ ) {
+    out.emplace_back( ring_.data(), size_ - first.size() );
+  }
+}
+
+void RingStorage::reserve( uint64_t len, vector<span<char>>& out )
+{
+  reserving_ = len > 0;
+  if ( len == 0 ) {
+    return;
+  }
+
+  const uint64_t tail = ( head_ + size_ ) % ring_.size();
+  const uint64_t first = min( len, ring_.size() - tail );
+
+  out.emplace_back( ring_.data() + tail, first );
+  if ( first < len ) {
+    out.emplace_back( ring_.data(), len - first );
+  }
+}
+
+void RingStorage::commit( uint64_t len )
+{
+  reserving_ = false;
+  size_ += len;
+}
+
+void ChunkedStorage::push( string& data )
+{
+  if ( data.empty() ) {
+    return;
+  }
+
+  size_ += data.size();
+  chunks_.emplace_back( move( data ) );
+}
+
+void ChunkedStorage::push( Buffer data )
+{
+  if ( data.empty() ) {
+    return;
+  }
+
+  size_ += data.size();
+  chunks_.push_back( move( data ) );
+}
+
+void ChunkedStorage::pop( uint64_t len )
+{
+  size_ -= len;
+
+  while ( len > 0 ) {
+    const uint64_t front_left = chunks_.front().size() - offset_;
+    if ( len < front_left ) {
+      offset_ += len;
+      return;
+    }
+
+    len -= front_left;
+    chunks_.pop_front();
+    offset_ = 0;
+  }
+}
+
+string_view ChunkedStorage::peek() const
+{
+  if ( chunks_.empty() ) {
+    return {};
+  }
+  return string_view { chunks_.front() }.substr( offset_ );
+}
+
+optional<Buffer> ChunkedStorage::peek_buffer() const
+{
+  if ( chunks_.empty() ) {
+    return {};
+  }
+  return chunks_.front().substr( offset_ );
+}
+
+void ChunkedStorage::peek_all( vector<string_view>& out ) const
+{
+  uint64_t offset = offset_;
+  for ( const auto& chunk : chunks_ ) {
+    out.push_back( string_view { chunk }.substr( offset ) );
+    offset = 0;
+  }
+}
+
+void ChunkedStorage::reserve( uint64_t len, vector<span<char>>& out )
+{
+  pending_ = make_shared_for_overwrite<char[]>( len );
+  out.emplace_back( pending_.get(), len );
+}
+
+void ChunkedStorage::commit( uint64_t len )
+{
+  // the chunk becomes the tail as it is, trimmed to what was written
+  const string_view written { pending_.get(), len };
+  push( Buffer { move( pending_ ), written } );
+}
+
+MirroredStorage::Mapping::Mapping( uint64_t min_size )
+{
+  const uint64_t page_size = sysconf( _SC_PAGESIZE );
+  size_ = max<uint64_t>( ( min_size + page_size - 1 ) / page_size, 1 ) * page_size;
+
+  const int fd = CheckSystemCall( "memfd_create", memfd_create( "minnow_bytestream", MFD_CLOEXEC ) );
+
+  // reserve twice the address space, then map the same region into both halves
+  void* base = mmap( nullptr, 2 * size_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+  void* first = MAP_FAILED;
+  void* second = MAP_FAILED;
+  if ( ftruncate( fd, static_cast<off_t>( size_ ) ) == 0 and base != MAP_FAILED ) {
+    constexpr int prot = PROT_READ | PROT_WRITE;
+    constexpr int flags = MAP_SHARED | MAP_FIXED;
+    first = mmap( base, size_, prot, flags, fd, 0 );
+    second = mmap( static_cast<char*>( base ) + size_, size_, prot, flags, fd, 0 );
+  }
+  const int saved_errno = errno;
+  ::close( fd ); // the mappings keep the region alive
+
+  if ( first == MAP_FAILED or second == MAP_FAILED ) {
+    if ( base != MAP_FAILED ) {
+      munmap( base, 2 * size_ );
+    }
+    throw unix_error { "MirroredStorage mmap", saved_errno };
+  }
+  base_ = static_cast<char*>( base );
+}
+
+MirroredStorage::Mapping::~Mapping()
+{
+  if ( base_ and munmap( base_, 2 * size_ ) != 0 ) {
+    cerr << "Exception destructing MirroredStorage: " << unix_error { "munmap" }.what() << "\n";
+  }
+}
+
+MirroredStorage::Mapping::Mapping( Mapping&& other ) noexcept
+  : base_( exchange( other.base_, nullptr ) ), size_( exchange( other.size_, 0 ) )
+{}
+
+MirroredStorage::Mapping& MirroredStorage::Mapping::operator=( Mapping&& other ) noexcept
+{
+  swap( base_, other.base_ );
+  swap( size_, other.size_ );
+  return *this;
+}
+
+MirroredStorage::MirroredStorage( const MirroredStorage& other )
+  : mapping_( other.mapping_.size() ), head_( other.head_ ), size_( other.size_ )
+{
+  copy_n( other.peek().data(), size_, mapping_.data() + head_ );
+}
+
+MirroredStorage& MirroredStorage::operator=( const MirroredStorage& other )
+{
+  if ( this != &other ) {
+    *this = MirroredStorage { other };
+  }
+  return *this;
+}
+
+void MirroredStorage::push( string_view data )
+{
+  // the bytes after the tail run on into the mirror, so one copy is enough
+  copy( data.begin(), data.end(), mapping_.data() + head_ + size_ );
+  size_ += data.size();
+}
+
+void MirroredStorage::pop( uint64_t len )
+{
+  size_ -= len;
+  head_ = ( head_ + len ) % mapping_.size();
+}
+
+void MirroredStorage::peek_all( vector<string_view>& out ) const
+{
+  if ( size_ > 0 ) {
+    out.push_back( peek() );
+  }
+}
+
+void MirroredStorage::reserve( uint64_t len, vector<span<char>>& out )
+{
+  out.emplace_back( mapping_.data() + head_ + size_, len );
+}
+
+PagedStorage::PagedStorage( const PagedStorage& other ) : head_( other.head_ )
+{
+  grow( other.size_ );
+  size_ = other.size_;
+  for ( uint64_t i = 0; i < pages_.size(); ++i ) {
+    copy_n( other.pages_[i].get(), page_size, pages_[i].get() );
+  }
+}
+
+PagedStorage& PagedStorage::operator=( const PagedStorage& other )
+{
+  if ( this != &other ) {
+    *this = PagedStorage { other };
+  }
+  return *this;
+}
+
+uint64_t PagedStorage::headroom() const
+{
+  const uint64_t pool_room = BufferPool::global().available() / page_size * page_size;
+  return pages_.size() * page_size - head_ - size_ + pool_room;
+}
+
+void PagedStorage::grow( uint64_t len )
+{
+  while ( pages_.size() < pages_needed( size_ + len ) ) {
+    pages_.push_back( BufferPool::global().allocate() );
+  }
+}
+
+void PagedStorage::shrink()
+{
+  if ( reserving_ ) {
+    return;
+  }
+  if ( size_ == 0 ) {
+    head_ = 0;
+  }
+  while ( pages_.size() > pages_needed( size_ ) ) {
+    pages_.pop_back();
+  }
+}
+
+void PagedStorage::push( string_view data )
+{
+  reserving_ = false;
+  grow( data.size() );
+
+  uint64_t tail = head_ + size_;
+  while ( not data.empty() ) {
+    const uint64_t len = min( data.size(), page_size - tail % page_size );
+    copy_n( data.data(), len, pages_[tail / page_size].get() + tail % page_size );
+    data.remove_prefix( len );
+    tail += len;
+    size_ += len;
+  }
+}
+
+void PagedStorage::pop( uint64_t len )
+{
+  size_ -= len;
+  head_ += len;
+  while ( head_ >= page_size ) {
+    pages_.pop_front();
+    head_ -= page_size;
+  }
+  shrink();
+}
+
+string_view PagedStorage::peek() const
+{
+  if ( size_ == 0 ) {
+    return {};
+  }
+  return { pages_.front().get() + head_, min( size_, page_size - head_ ) };
+}
+
+optional<Buffer> PagedStorage::peek_buffer() const
+{
+  if ( size_ == 0 ) {
+    return {};
+  }
+  return Buffer { pages_.front(), peek() };
+}
+
+void PagedStorage::peek_all( vector<string_view>& out ) const
+{
+  uint64_t offset = head_;
+  uint64_t left = size_;
+  for ( const auto& page : pages_ ) {
+    if ( left == 0 ) {
+      break;
+    }
+    const uint64_t len = min( left, page_size - offset );
+    out.emplace_back( page.get() + offset, len );
+    left -= len;
+    offset = 0;
+  }
+}
+
+void PagedStorage::reserve( uint64_t len, vector<span<char>>& out )
+{
+  reserving_ = false;
+  shrink(); // drop the pages of an earlier reservation that was never committed
+  grow( len );
+  reserving_ = len > 0;
+
+  uint64_t tail = head_ + size_;
+  while ( len > 0 ) {
+    const uint64_t span_len = min( len, page_size - tail % page_size );
+    out.emplace_back( pages_[tail / page_size].get() + tail % page_size, span_len );
+    len -= span_len;
+    tail += span_len;
+  }
+}
+
+void PagedStorage::commit( uint64_t len )
+{
+  reserving_ = false;
+  size_ += len;
+  shrink();
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "buffer.hh"
+#include "buffer_pool.hh"
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Storage engines behind a ByteStream. Each engine holds the bytes that have been pushed
+ * and not yet popped; the ByteStream itself enforces the capacity, so `push` and `reserve`
+ * are only ever asked for as many bytes as fit, and `commit` only for bytes just reserved.
+ * An engine's `headroom` is how many more bytes it could take regardless of the capacity.
+ */
+
+// A fixed-capacity ring buffer, allocated once at construction.
+class RingStorage
+{
+  std::string ring_;
+  uint64_t head_ {};
+  uint64_t size_ {};
+  bool reserving_ {}; // an uncommitted reservation's spans must stay where they are
+
+public:
+  explicit RingStorage( uint64_t capacity ) : ring_( capacity, 0 ) {}
+
+  uint64_t size() const { return size_; }
+  uint64_t headroom() const { return std::numeric_limits<uint64_t>::max(); }
+  void push( std::string_view data ); // copies data into the ring
+  void pop( uint64_t len );
+  std::string_view peek() const; // contiguous bytes up to the wrap point
+  std::optional<Buffer> peek_buffer() const { return {}; } // ring memory is reused, so it can't be shared
+  void peek_all( std::vector<std::string_view>& out ) const;
+
+  void reserve( uint64_t len, std::vector<std::span<char>>& out ); // the free space after the tail, in place
+  void commit( uint64_t len );
+};
+
+// A queue of the pushed strings (or Buffers) themselves: push moves them in and pop never copies.
+class ChunkedStorage
+{
+  std::deque<Buffer> chunks_ {};
+  uint64_t offset_ {}; // bytes already popped from the front chunk
+  uint64_t size_ {};
+  std::shared_ptr<char[]> pending_ {}; // reserved chunk (uninitialized), not yet committed
+
+public:
+  uint64_t size() const { return size_; }
+  uint64_t headroom() const { return std::numeric_limits<uint64_t>::max(); }
+  void push( std::string& data ); // takes ownership of data
+  void push( Buffer data );       // shares data's storage
+  void pop( uint64_t len );
+  std::string_view peek() const;             // the unread part of the front chunk
+  std::optional<Buffer> peek_buffer() const; // the same bytes, sharing the chunk's storage
+  void peek_all( std::vector<std::string_view>& out ) const;
+
+  void reserve( uint64_t len, std::vector<std::span<char>>& out ); // a fresh chunk, the tail on commit
+  void commit( uint64_t len );
+};
+
+// A ring buffer whose memory is mapped twice, back to back, so any window of up to `capacity`
+// bytes is contiguous in virtual memory: peek always returns everything buffered.
+class MirroredStorage
+{
+  // Owns the double mapping of one memfd region of `size` bytes
+  class Mapping
+  {
+    char* base_ {};
+    uint64_t size_ {};
+
+  public:
+    explicit Mapping( uint64_t min_size ); // rounds up to a whole number of pages
+    ~Mapping();
+
+    char* data() const { return base_; }
+    uint64_t size() const { return size_; }
+
+    Mapping( const Mapping& other ) = delete;
+    Mapping& operator=( const Mapping& other ) = delete;
+    Mapping( Mapping&& other ) noexcept;
+    Mapping& operator=( Mapping&& other ) noexcept;
+  };
+
+  Mapping mapping_;
+  uint64_t head_ {};
+  uint64_t size_ {};
+
+public:
+  explicit MirroredStorage( uint64_t capacity ) : mapping_( capacity ) {}
+
+  // copies get their own mapping
+  MirroredStorage( const MirroredStorage& other );
+  MirroredStorage& operator=( const MirroredStorage& other );
+  MirroredStorage( MirroredStorage&& other ) noexcept = default;
+  MirroredStorage& operator=( MirroredStorage&& other ) noexcept = default;
+  ~MirroredStorage() = default;
+
+  uint64_t size() const { return size_; }
+  uint64_t headroom() const { return std::numeric_limits<uint64_t>::max(); }
+  void push( std::string_view data ); // copies data into the ring
+  void pop( uint64_t len );
+  std::string_view peek() const { return { mapping_.data() + head_, size_ }; }
+  std::optional<Buffer> peek_buffer() const { return {}; } // ring memory is reused, so it can't be shared
+  void peek_all( std::vector<std::string_view>& out ) const;
+
+  void reserve( uint64_t len, std::vector<std::span<char>>& out ); // always a single span
+  void commit( uint64_t len ) { size_ += len; }
+};
+
+// Fixed-size pages drawn from BufferPool::global() as bytes arrive and returned as they are popped,
+// so an idle stream holds no memory. The pages are refcounted, so peek_buffer can share them.
+class PagedStorage
+{
+  std::deque<std::shared_ptr<char>> pages_ {};
+  uint64_t head_ {}; // offset of the first unread byte in the front page
+  uint64_t size_ {};
+  bool reserving_ {}; // an uncommitted reservation's pages must stay where they are
+
+  static constexpr uint64_t page_size = BufferPool::page_size;
+
+  uint64_t pages_needed( uint64_t len ) const { return ( head_ + len + page_size - 1 ) / page_size; }
+  void grow( uint64_t len ); // makes sure there are pages for `len` more bytes after the tail
+  void shrink();             // returns any pages past the tail to the pool
+
+public:
+  PagedStorage() = default;
+
+  // copies get their own pages
+  PagedStorage( const PagedStorage& other );
+  PagedStorage& operator=( const PagedStorage& other );
+  PagedStorage( PagedStorage&& other ) noexcept = default;
+  PagedStorage& operator=( PagedStorage&& other ) noexcept = default;
+  ~PagedStorage() = default;
+
+  uint64_t size() const { return size_; }
+  uint64_t headroom() const; // the rest of the tail page, plus what the pool's budget allows
+  void push( std::string_view data );
+  void pop( uint64_t len );
+  std::string_view peek() const;             // the unread part of the front page
+  std::optional<Buffer> peek_buffer() const; // the same bytes, sharing the page
+  void peek_all( std::vector<std::string_view>& out ) const;
+
+  void reserve( uint64_t len, std::vector<std::span<char>>& out ); // the free space after the tail, across pages
+  void commit( uint64_t len );
+};
@@ -0,0 +1,183 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+// The initial window (RFC 6928): ten segments, within 14600 bytes (but at least two segments)
+static uint64_t initial_window( uint64_t mss )
+{
+  return min( 10 * mss, max<uint64_t>( 2 * mss, 14600 ) );
+}
+
+NewReno::NewReno( uint64_t mss ) : mss_( mss ), cwnd_( initial_window( mss ) ) {}
+
+void NewReno::on_ack( uint64_t acked_bytes, uint64_t /* now_ms */ )
+{
+  // slow start: a segment per segment acknowledged
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ += min( acked_bytes, mss_ );
+    return;
+  }
+
+  // congestion avoidance: a segment per window acknowledged
+  bytes_acked_ += acked_bytes;
+  if ( bytes_acked_ >= cwnd_ ) {
+    bytes_acked_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+void NewReno::on_loss( uint64_t bytes_in_flight, uint64_t /* now_ms */ )
+{
+  ssthresh_ = max( bytes_in_flight / 2, 2 * mss_ );
+  cwnd_ = ssthresh_;
+  bytes_acked_ = 0;
+}
+
+void NewReno::on_timeout( uint64_t bytes_in_flight, uint64_t /* now_ms */ )
+{
+  ssthresh_ = max( bytes_in_flight / 2, 2 * mss_ );
+  cwnd_ = mss_;
+  bytes_acked_ = 0;
+}
+
+Cubic::Cubic( uint64_t mss )
+  : mss_( static_cast<double>( mss ) ), cwnd_( static_cast<double>( initial_window( mss ) ) )
+{}
+
+uint64_t Cubic::ssthresh() const
+{
+  return ssthresh_ == numeric_limits<double>::max() ? numeric_limits<uint64_t>::max()
+                                                     : static_cast<uint64_t>( ssthresh_ );
+}
+
+void Cubic::on_ack( uint64_t acked_bytes, uint64_t now_ms )
+{
+  const auto acked = static_cast<double>( acked_bytes );
+
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ += min( acked, mss_ );
+    return;
+  }
+
+  // a new epoch of congestion avoidance: the cubic function starts from here, to reach w_max_ after k_ seconds
+  if ( not in_epoch_ ) {
+    in_epoch_ = true;
+    epoch_start_ms_ = now_ms;
+    w_est_ = cwnd_;
+    if ( cwnd_ < w_max_ ) {
+      k_ = cbrt( ( w_max_ - cwnd_ ) / mss_ / C );
+    } else {
+      k_ = 0;
+      w_max_ = cwnd_;
+    }
+  }
+
+  // the cubic function's window (in segments, after t seconds), kept within [cwnd, 1.5 cwnd]
+  const double t = static_cast<double>( now_ms - epoch_start_ms_ ) / 1000;
+  const double w_cubic = ( C * pow( t - k_, 3 ) + w_max_ / mss_ ) * mss_;
+  const double target = clamp( w_cubic, cwnd_, 1.5 * cwnd_ );
+
+  // what Reno, with CUBIC's backoff, would have: an alpha_cubic segments per window acknowledged
+  constexpr double alpha_cubic = 3 * ( 1 - BETA ) / ( 1 + BETA );
+  w_est_ += alpha_cubic * mss_ * acked / cwnd_;
+
+  if ( w_cubic < w_est_ ) {
+    cwnd_ = w_est_; // the Reno-friendly region
+  } else {
+    cwnd_ += ( target - cwnd_ ) * acked / cwnd_;
+  }
+}
+
+void Cubic::reduce()
+{
+  in_epoch_ = false;
+
+  // fast convergence: a flow whose window keeps shrinking releases bandwidth sooner
+  w_max_ = cwnd_ < w_max_ ? cwnd_ * ( 1 + BETA ) / 2 : cwnd_;
+  ssthresh_ = max( cwnd_ * BETA, 2 * mss_ );
+}
+
+void Cubic::on_loss( uint64_t /* bytes_in_flight */, uint64_t /* now_ms */ )
+{
+  reduce();
+  cwnd_ = ssthresh_;
+}
+
+void Cubic::on_timeout( uint64_t /* bytes_in_flight */, uint64_t /* now_ms */ )
+{
+  reduce();
+  cwnd_ = mss_;
+}
+
+static variant<NoCongestionControl, NewReno, Cubic> make_algorithm( CongestionControl::Algorithm algorithm,
+                                                                     uint64_t mss )
+{
+  switch ( algorithm ) {
+    case CongestionControl::Algorithm::NewReno:
+      return NewReno { mss };
+    case CongestionControl::Algorithm::Cubic:
+      return Cubic { mss };
+    case CongestionControl::Algorithm::None:
+      break;
+  }
+  return NoCongestionControl {};
+}
+
+CongestionControl::CongestionControl( Algorithm algorithm, uint64_t mss )
+  : kind_( algorithm ), algorithm_( make_algorithm( algorithm, mss ) ), mss_( mss )
+{}
+
+void CongestionControl::set_mss( uint64_t mss )
+{
+  *this = CongestionControl { kind_, mss };
+}
+
+uint64_t CongestionControl::cwnd() const
+{
+  const uint64_t cwnd = visit( []( const auto& algorithm ) { return algorithm.cwnd(); }, algorithm_ );
+  return cwnd > numeric_limits<uint64_t>::max() - inflation_ ? numeric_limits<uint64_t>::max() : cwnd + inflation_;
+}
+
+uint64_t CongestionControl::ssthresh() const
+{
+  return visit( []( const auto& algorithm ) { return algorithm.ssthresh(); }, algorithm_ );
+}
+
+void CongestionControl::on_ack( uint64_t acked_bytes, uint64_t now_ms )
+{
+  visit( [&]( auto& algorithm ) { algorithm.on_ack( acked_bytes, now_ms ); }, algorithm_ );
+}
+
+void CongestionControl::on_loss( uint64_t bytes_in_flight, uint64_t now_ms )
+{
+  visit( [&]( auto& algorithm ) { algorithm.on_loss( bytes_in_flight, now_ms ); }, algorithm_ );
+}
+
+void CongestionControl::on_timeout( uint64_t bytes_in_flight, uint64_t now_ms )
+{
+  inflation_ = 0;
+  visit( [&]( auto& algorithm ) { algorithm.on_timeout( bytes_in_flight, now_ms ); }, algorithm_ );
+}
+
+void CongestionControl::on_dup_ack()
+{
+  inflation_ += mss_;
+}
+
+void CongestionControl::on_partial_ack( uint64_t acked_bytes )
+{
+  // deflate by what was acknowledged, but let one new segment go if a whole one was (RFC 6582)
+  inflation_ -= min( inflation_, acked_bytes );
+  if ( acked_bytes >= mss_ ) {
+    inflation_ += mss_;
+  }
+}
+
+void CongestionControl::on_recovery_end()
+{
+  inflation_ = 0;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <variant>
+
+/*
+ * Congestion control algorithms for the TCPSender. Each one keeps a congestion window (cwnd)
+ * and a slow-start threshold (ssthresh), both in bytes, and the sender never has more than
+ * min( cwnd, the peer's window ) sequence numbers in flight. The sender reports:
+ *
+ *   `on_ack`: the peer acknowledged `acked_bytes` new bytes (outside loss recovery)
+ *   `on_loss`: loss recovery began, with `bytes_in_flight` outstanding
+ *   `on_timeout`: the retransmission timer expired, with `bytes_in_flight` outstanding
+ *
+ * Fast recovery's window inflation (RFC 5681/6582) is the same for every algorithm, so CongestionControl
+ * applies it on top of the algorithm's cwnd: each duplicate ACK during loss recovery means a segment left
+ * the network, so one more may be sent; a partial ACK takes back what it acknowledged; the end of recovery
+ * takes back the rest.
+ *
+ * `now_ms` is the sender's clock: the sum of the time passed to its tick().
+ */
+
+// No congestion window at all: only the peer's window limits the sender.
+class NoCongestionControl
+{
+public:
+  uint64_t cwnd() const { return std::numeric_limits<uint64_t>::max(); }
+  uint64_t ssthresh() const { return std::numeric_limits<uint64_t>::max(); }
+  void on_ack( uint64_t /* acked_bytes */, uint64_t /* now_ms */ ) {}
+  void on_loss( uint64_t /* bytes_in_flight */, uint64_t /* now_ms */ ) {}
+  void on_timeout( uint64_t /* bytes_in_flight */, uint64_t /* now_ms */ ) {}
+};
+
+// Slow start and additive increase, halving on loss (RFC 5681, with the NewReno response of RFC 6582).
+class NewReno
+{
+  uint64_t mss_;
+  uint64_t cwnd_;
+  uint64_t ssthresh_ = std::numeric_limits<uint64_t>::max();
+  uint64_t bytes_acked_ {}; // in congestion avoidance, since cwnd last grew
+
+public:
+  explicit NewReno( uint64_t mss );
+
+  uint64_t cwnd() const { return cwnd_; }
+  uint64_t ssthresh() const { return ssthresh_; }
+  void on_ack( uint64_t acked_bytes, uint64_t now_ms );
+  void on_loss( uint64_t bytes_in_flight, uint64_t now_ms );
+  void on_timeout( uint64_t bytes_in_flight, uint64_t now_ms );
+};
+
+// Growth along a cubic function of the time since the last loss, backing off by 30% on loss (RFC 9438).
+class Cubic
+{
+  static constexpr double C = 0.4;
+  static constexpr double BETA = 0.7;
+
+  double mss_;
+  double cwnd_;
+  double ssthresh_ = std::numeric_limits<double>::max();
+  double w_max_ {};           // cwnd just before the last loss
+  double w_est_ {};           // what Reno would have grown cwnd to since then
+  double k_ {};               // seconds from the epoch's start until the cubic function reaches w_max_
+  uint64_t epoch_start_ms_ {}; // when this congestion-avoidance epoch began
+  bool in_epoch_ {};
+
+  void reduce();
+
+public:
+  explicit Cubic( uint64_t mss );
+
+  uint64_t cwnd() const { return static_cast<uint64_t>( cwnd_ ); }
+  uint64_t ssthresh() const;
+  void on_ack( uint64_t acked_bytes, uint64_t now_ms );
+  void on_loss( uint64_t bytes_in_flight, uint64_t now_ms );
+  void on_timeout( uint64_t bytes_in_flight, uint64_t now_ms );
+};
+
+// The TCPSender's congestion control, whichever algorithm it is.
+class CongestionControl
+{
+public:
+  enum class Algorithm
+  {
+    None,
+    NewReno,
+    Cubic,
+  };
+
+private:
+  Algorithm kind_;
+  std::variant<NoCongestionControl, NewReno, Cubic> algorithm_;
+  uint64_t mss_;
+  uint64_t inflation_ {}; // fast recovery's additions to the algorithm's cwnd
+
+public:
+  explicit CongestionControl( Algorithm algorithm = Algorithm::None, uint64_t mss = 1 );
+
+  // Start afresh with another MSS (the one agreed in the handshake, before any data is sent)
+  void set_mss( uint64_t mss );
+
+  uint64_t cwnd() const;
+  uint64_t ssthresh() const;
+  void on_ack( uint64_t acked_bytes, uint64_t now_ms );
+  void on_loss( uint64_t bytes_in_flight, uint64_t now_ms );
+  void on_timeout( uint64_t bytes_in_flight, uint64_t now_ms );
+
+  // fast recovery
+  void on_dup_ack();
+  void on_partial_ack( uint64_t acked_bytes );
+  void on_recovery_end();
+};
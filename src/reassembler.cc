@@ -1,197 +1,338 @@
 #include "reassembler.hh"
 
 #include <algorithm>
-#include <cstring>
-#include <optional>
+#include <bit>
+#include <iterator>
 
 using namespace std;
 
-bool Reassembler::_check_str( uint64_t& first_index, std::string& data, Writer& output ) const
+// The bitmap engine's bits are slots of a ring: ranges wrap around at `size`, and are processed a word at a time.
+
+// Set (or clear) `len` bits from `slot`, returning how many of them changed
+static uint64_t update_bits( vector<uint64_t>& bits, uint64_t size, uint64_t slot, uint64_t len, bool set )
+{
+  uint64_t changed = 0;
+  while ( len > 0 ) {
+    const uint64_t span = min( { 64 - slot % 64, size - slot, len } );
+    const uint64_t mask = ( span == 64 ? ~uint64_t {} : ( uint64_t { 1 } << span ) - 1 ) << ( slot % 64 );
+    uint64_t& word = bits[slot / 64];
+
+    changed += popcount( set ? mask & ~word : mask & word );
+    word = set ? word | mask : word & ~mask;
+    len -= span;
+    slot = ( slot + span ) % size;
+  }
+  return changed;
+}
+
+// How many bits from `slot` are set (or clear), up to `limit`
+static uint64_t count_run( const vector<uint64_t>& bits,
+                           uint64_t size,
+                           uint64_t slot,
+                           uint64_t limit,
+                           bool set = true )
+{
+  uint64_t run = 0;
+  while ( run < limit ) {
+    const uint64_t span = min( { 64 - slot % 64, size - slot, limit - run } );
+    const uint64_t word = set ? bits[slot / 64] : ~bits[slot / 64];
+    const uint64_t ones = min<uint64_t>( countr_one( word >> ( slot % 64 ) ), span );
+
+    run += ones;
+    if ( ones < span ) {
+      break;
+    }
+    slot = ( slot + span ) % size;
+  }
+  return run;
+}
+
+bool Reassembler::_check_str( uint64_t& first_index, Buffer& data, const Writer& output ) const
 {
-  const uint64_t cap = output.available_capacity();
+  const uint64_t window_end = _unassembled_index + output.available_capacity();
+  const uint64_t end_index = min( first_index + data.length(), window_end );
 
-  // discard bytes beyond the available capacity
-  if ( output.available_capacity() == 0 || first_index + data.length() < _unassembled_index
-       || first_index >= _unassembled_index + output.available_capacity() ) {
+  // discard data with no new bytes inside the window
+  if ( end_index <= max( first_index, _unassembled_index ) ) {
     return false;
   }
 
+  // adjust data that overlaps the capacity
+  data = data.substr( 0, end_index - first_index );
+
   // adjust data that overlaps the first unassembled index
   if ( first_index < _unassembled_index ) {
-    data.erase( 0, _unassembled_index - first_index );
+    data = data.substr( _unassembled_index - first_index );
     first_index = _unassembled_index;
   }
 
-  // adjust data that overlaps the capacity
-  if ( first_index + data.length() > _unassembled_index + cap ) {
-    data.erase( _unassembled_index + cap - first_index );
-  }
-
   return true;
 }
 
-bool Reassembler::_push_str( uint64_t first_index, std::string& data, Writer& output )
+void Reassembler::_push_str( Buffer& data, Writer& output )
 {
-  if ( first_index == _unassembled_index ) {
-    output.push( data );
-    _unassembled_index += data.length();
-
-    if ( _eof_index == first_index ) {
-      output.close();
-    }
-    return true;
-  }
-  return false;
+  _unassembled_index += data.length();
+  output.push( move( data ) );
 }
 
-void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring, Writer& output )
+void Reassembler::insert( uint64_t first_index, Buffer data, bool is_last_substring, Writer& output )
 {
-  bool valid = {};
-  bool pushed = {};
-  std::optional<ReassemblerBuffer> peek = {};
-  ReassemblerBuffer buf = {};
+  // store the EOF index once the whole last substring fits in the window
+  if ( is_last_substring and first_index + data.length() <= _unassembled_index + output.available_capacity() ) {
+    _eof_index = first_index + data.length();
+  }
 
-  uint64_t eof_pos = first_index + data.length();
+  // a slice of the data keeps all of it alive
+  const uint64_t pinned = data.length();
 
   // check & tailor data according to capacity
-  valid = _check_str( first_index, data, output );
-  if ( !valid ) {
-    return;
+  if ( _check_str( first_index, data, output ) ) {
+    if ( _engine == Engine::Bitmap ) {
+      if ( first_index == _unassembled_index ) {
+        _bitmap_clear( first_index, data.length() );
+        _push_str( data, output );
+        _bitmap_drain( output );
+      } else {
+        _bitmap_insert( first_index, data, output );
+      }
+    } else if ( first_index == _unassembled_index ) {
+      _push_str( data, output );
+      _buffer_drain( output );
+    } else {
+      if ( _default_limits ) {
+        _max_fragments = max( default_max_fragments, output.capacity() / fragment_overhead );
+        _max_overhead_bytes = max( default_max_overhead_bytes, output.capacity() );
+      }
+      _buffer_insert( first_index, data, pinned );
+      _buffer_evict();
+    }
   }
 
-  // store the EOF index if EOF position is not changed
-  if ( is_last_substring && !( eof_pos != first_index + data.length() ) ) {
-    _eof_index = first_index;
+  if ( _unassembled_index == _eof_index ) {
+    output.close();
   }
+}
 
-  // push data to output if it fits
-  pushed = _push_str( first_index, data, output );
-  if ( !pushed ) {
-    // push data into unassembled buffer
-    _buffer_insert( first_index, data );
-  } else {
-    // update buffer since unassembled index is changed
-    _buffer_update();
-
-    // check unassembled buffer
-    peek = _buffer_peak();
-    if ( !peek.has_value() ) {
-      return;
-    }
+uint64_t Reassembler::bytes_pending() const
+{
+  return _unassembled_bytes;
+}
 
-    buf = peek.value();
-    valid = _check_str( buf.first, buf.second, output );
-    if ( !valid ) {
-      return;
+vector<pair<uint64_t, uint64_t>> Reassembler::held_intervals( size_t max_count ) const
+{
+  vector<pair<uint64_t, uint64_t>> intervals;
+
+  if ( _engine == Engine::Bitmap ) {
+    // find the runs of set bits, stopping once every held byte is accounted for
+    const uint64_t window_end = _unassembled_index + _ring.size();
+    uint64_t index = _unassembled_index;
+    uint64_t found = 0;
+    while ( found < _unassembled_bytes and intervals.size() < max_count ) {
+      index += count_run( _present, _ring.size(), index % _ring.size(), window_end - index, false );
+      const uint64_t run = count_run( _present, _ring.size(), index % _ring.size(), window_end - index );
+      intervals.emplace_back( index, index + run );
+      found += run;
+      index += run;
     }
+    return intervals;
+  }
 
-    pushed = _push_str( buf.first, buf.second, output );
-    while ( pushed ) {
-      _buffer_pop();
-
-      peek = _buffer_peak();
-      if ( !peek.has_value() ) {
-        break;
-      }
-
-      buf = peek.value();
-      valid = _check_str( buf.first, buf.second, output );
-      if ( !valid ) {
-        break;
-      }
-
-      pushed = _push_str( buf.first, buf.second, output );
+  // fragments that touch make up one interval
+  for ( const auto& [first_index, fragment] : _unassembled_buffer ) {
+    const uint64_t end_index = first_index + fragment.data.length();
+    if ( not intervals.empty() and intervals.back().second == first_index ) {
+      intervals.back().second = end_index;
+    } else if ( intervals.size() < max_count ) {
+      intervals.emplace_back( first_index, end_index );
+    } else {
+      break;
     }
   }
+  return intervals;
 }
 
-uint64_t Reassembler::bytes_pending() const
+void Reassembler::set_limits( uint64_t max_fragments, uint64_t max_overhead_bytes )
 {
-  return _unassembled_bytes;
+  _max_fragments = max_fragments;
+  _max_overhead_bytes = max_overhead_bytes;
+  _default_limits = false;
+  _buffer_evict();
 }
 
-void Reassembler::_buffer_insert( uint64_t first_index, std::string& data )
+void Reassembler::_buffer_insert( uint64_t first_index, Buffer& data, uint64_t pinned )
 {
-  auto it = _unassembled_buffer.begin();
-  const auto tail = _unassembled_buffer.end();
-  const uint64_t end_index = first_index + data.length();
+  uint64_t end_index = first_index + data.length();
 
-  // sort buffer according to the first index
-  while ( it != tail && it->first <= first_index ) {
-    const uint64_t it_end = it->first + it->second.length();
+  // skip the part the previous fragment already holds
+  auto next = _unassembled_buffer.upper_bound( first_index );
+  if ( next != _unassembled_buffer.begin() ) {
+    const auto prev = std::prev( next );
+    const uint64_t prev_end = prev->first + prev->second.data.length();
 
-    // inserted data is inside the current one
-    if ( end_index <= it_end ) {
+    // inserted data is inside the previous one
+    if ( end_index <= prev_end ) {
       return;
     }
 
-    // current is inside the inserted data
-    if ( it->first == first_index && it_end < end_index ) {
-      _unassembled_bytes -= it->second.length();
-      it = _unassembled_buffer.erase( it );
-      continue;
+    if ( prev_end > first_index ) {
+      data = data.substr( prev_end - first_index );
+      first_index = prev_end;
     }
+  }
 
-    // partially overlapped
-    if ( it_end > first_index && it_end < end_index ) {
-      it->second.erase( first_index - it->first );
-      _unassembled_bytes -= ( it_end - first_index );
+  // remove fragments the data covers completely, and clip the data where a later one begins
+  while ( next != _unassembled_buffer.end() and next->first < end_index ) {
+    if ( next->first + next->second.data.length() > end_index ) {
+      end_index = next->first;
+      data = data.substr( 0, end_index - first_index );
+      break;
     }
-    it++;
-  }
-  // insert data into buffer
-  _unassembled_buffer.insert( it, ReassemblerBuffer { first_index, data } );
-  _unassembled_bytes += data.length();
-
-  // remove or tailor the next overlapped data
-  while ( it != tail && it->first < end_index ) {
-    // totally overlapped
-    if ( it->first + it->second.length() <= end_index ) {
-      _unassembled_bytes -= it->second.length();
-      it = _unassembled_buffer.erase( it );
-    } else {
-      // partially overlapped
-      const uint64_t num = end_index - it->first;
-      it->second.erase( 0, num );
-      it->first = end_index;
-      _unassembled_bytes -= num;
-      it++;
+    _buffer_erase( next++ );
+  }
+
+  if ( data.empty() ) {
+    return;
+  }
+
+  // A slice that continues a touching neighbour in the same storage joins it, as one fragment. Small ones
+  // from different Buffers are copied onto the end of it instead, which stays in its place in the map.
+  Fragment fragment { move( data ), pinned };
+  if ( next != _unassembled_buffer.begin() ) {
+    const auto prev = std::prev( next );
+    Fragment& before = prev->second;
+    if ( prev->first + before.data.length() == first_index ) {
+      if ( auto joined = before.data.joined( fragment.data ) ) {
+        fragment = { move( *joined ), before.pinned + fragment.pinned };
+        first_index = prev->first;
+        _buffer_erase( prev );
+      } else if ( fragment.data.length() <= coalesce_limit
+                  and ( before.copied or before.data.length() + fragment.data.length() <= coalesce_limit ) ) {
+        _unassembled_bytes += fragment.data.length();
+        _overhead_bytes -= before.pinned - before.data.length();
+        before = _coalesced( move( before ), fragment );
+        _overhead_bytes += before.pinned - before.data.length();
+        // the copy is of another storage than the next fragment, so can't join it, but may touch it
+        _runs -= next != _unassembled_buffer.end() and next->first == end_index;
+        return;
+      }
     }
   }
+  if ( next != _unassembled_buffer.end() and next->first == end_index ) {
+    if ( auto joined = fragment.data.joined( next->second.data ) ) {
+      fragment = { move( *joined ), fragment.pinned + next->second.pinned };
+      _buffer_erase( next++ );
+    }
+  }
+
+  _unassembled_bytes += fragment.data.length();
+  _overhead_bytes += fragment_overhead + fragment.pinned - fragment.data.length();
+  const auto it = _unassembled_buffer.emplace_hint( next, first_index, move( fragment ) );
+  _runs += 1;
+  _runs -= _buffer_touching( it );
 }
 
-std::optional<ReassemblerBuffer> Reassembler::_buffer_peak()
+void Reassembler::_buffer_erase( std::map<uint64_t, Fragment>::iterator it )
 {
-  if ( _unassembled_buffer.empty() ) {
-    return std::nullopt;
+  _runs += _buffer_touching( it );
+  _runs -= 1;
+  _unassembled_bytes -= it->second.data.length();
+  _overhead_bytes -= fragment_overhead + it->second.pinned - it->second.data.length();
+  _unassembled_buffer.erase( it );
+}
+
+// One fragment of the bytes of two touching ones: a copy, or `front`'s copy grown in place
+Reassembler::Fragment Reassembler::_coalesced( Fragment front, const Fragment& back )
+{
+  string bytes = front.copied ? move( static_cast<string&>( front.data ) ) : string { string_view { front.data } };
+  bytes.append( string_view { back.data } );
+  const uint64_t pinned = bytes.capacity();
+  return { Buffer { move( bytes ) }, pinned, true };
+}
+
+// How many of its neighbours a fragment touches (so joins into one run)
+uint64_t Reassembler::_buffer_touching( std::map<uint64_t, Fragment>::const_iterator it ) const
+{
+  uint64_t touching = 0;
+  if ( it != _unassembled_buffer.begin() ) {
+    const auto prev = std::prev( it );
+    touching += prev->first + prev->second.data.length() == it->first;
+  }
+  const auto next = std::next( it );
+  if ( next != _unassembled_buffer.end() ) {
+    touching += it->first + it->second.data.length() == next->first;
   }
-  return _unassembled_buffer.front();
+  return touching;
 }
 
-void Reassembler::_buffer_pop()
+void Reassembler::_buffer_evict()
 {
-  if ( _unassembled_buffer.empty() ) {
-    return;
+  // the fragment furthest from the edge is the one that will be written last, so it goes first
+  while ( not _unassembled_buffer.empty()
+          and ( _runs > _max_fragments or _overhead_bytes > _max_overhead_bytes ) ) {
+    const auto last = std::prev( _unassembled_buffer.end() );
+    _fragments_evicted++;
+    _bytes_evicted += last->second.data.length();
+    _buffer_erase( last );
   }
+}
+
+void Reassembler::_buffer_drain( Writer& output )
+{
+  while ( not _unassembled_buffer.empty() and _unassembled_buffer.begin()->first <= _unassembled_index ) {
+    uint64_t first_index = _unassembled_buffer.begin()->first;
+    Buffer data = _unassembled_buffer.begin()->second.data;
+    _buffer_erase( _unassembled_buffer.begin() );
 
-  const uint64_t len = _unassembled_buffer.front().second.length();
-  _unassembled_buffer.pop_front();
-  _unassembled_bytes -= len;
+    if ( _check_str( first_index, data, output ) ) {
+      _push_str( data, output );
+    }
+  }
 }
 
-bool Reassembler::_buffer_empty()
+void Reassembler::_bitmap_insert( uint64_t first_index, std::string_view data, const Writer& output )
 {
-  return _unassembled_buffer.empty();
+  if ( _ring.empty() ) {
+    _ring.resize( output.capacity() );
+    _present.assign( ( _ring.size() + 63 ) / 64, 0 );
+  }
+
+  const uint64_t slot = first_index % _ring.size();
+  const uint64_t first = min( data.length(), _ring.size() - slot );
+  copy_n( data.data(), first, _ring.data() + slot );
+  copy_n( data.data() + first, data.length() - first, _ring.data() );
+
+  _unassembled_bytes += update_bits( _present, _ring.size(), slot, data.length(), true );
 }
 
-void Reassembler::_buffer_update()
+void Reassembler::_bitmap_clear( uint64_t first_index, uint64_t len )
 {
-  auto it = _unassembled_buffer.begin();
-  const auto tail = _unassembled_buffer.end();
+  if ( _unassembled_bytes > 0 ) {
+    _unassembled_bytes -= update_bits( _present, _ring.size(), first_index % _ring.size(), len, false );
+  }
+}
 
-  // remove totally overlapped data
-  while ( it != tail && it->first + it->second.length() < _unassembled_index ) {
-    _unassembled_bytes -= it->second.length();
-    it = _unassembled_buffer.erase( it );
+void Reassembler::_bitmap_drain( Writer& output )
+{
+  if ( _unassembled_bytes == 0 ) {
+    return;
   }
+
+  // the held bytes that continue the stream go straight into its storage
+  uint64_t slot = _unassembled_index % _ring.size();
+  const uint64_t run = count_run( _present, _ring.size(), slot, _unassembled_bytes );
+  uint64_t written = 0;
+  output.reserve( run, _drain_spans );
+  for ( const auto span : _drain_spans ) {
+    for ( uint64_t copied = 0; copied < span.size(); ) {
+      const uint64_t len = min( span.size() - copied, _ring.size() - slot );
+      copy_n( _ring.data() + slot, len, span.data() + copied );
+      copied += len;
+      slot = ( slot + len ) % _ring.size();
+    }
+    written += span.size();
+  }
+  output.commit( written );
+
+  _bitmap_clear( _unassembled_index, written );
+  _unassembled_index += written;
 }
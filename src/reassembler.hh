@@ -2,35 +2,108 @@
 
 #include "byte_stream.hh"
 
-#include <list>
-#include <optional>
+#include <cstdint>
+#include <map>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
-
-using ReassemblerBuffer = std::pair<uint64_t, std::string>;
+#include <vector>
 
 class Reassembler
 {
+public:
+  // How the Reassembler holds bytes that can't be written yet
+  enum class Engine
+  {
+    Map,    // ordered map of fragments: memory follows the bytes pending (default)
+    Bitmap, // ring as large as the stream's capacity, plus a presence bitmap: fixed memory, no allocation
+  };
+
 private:
+  Engine _engine;
   uint64_t _eof_index = -1;
   uint64_t _unassembled_bytes = {};
   uint64_t _unassembled_index = {};
-  std::list<ReassemblerBuffer> _unassembled_buffer = {};
-  bool _check_str( uint64_t& first_index, std::string& data, Writer& output ) const;
-  bool _push_str( uint64_t first_index, std::string& data, Writer& output );
+
+  // A pending fragment: a slice of an inserted Buffer, which keeps all `pinned` bytes of it alive; or the
+  // Reassembler's own copy of touching fragments, which can grow in place
+  struct Fragment
+  {
+    Buffer data;
+    uint64_t pinned;
+    bool copied {};
+  };
+
+  // Pending fragments keyed by first index. They are slices of the inserted Buffers, so trimming
+  // never copies. They never overlap. Touching slices of the same storage are joined into one. A small
+  // slice of another Buffer is copied onto the end of the fragment it continues (see `coalesce_limit`),
+  // so a run of small segments doesn't cost a node and a push each. Others may touch, making up a run
+  // that the drain pushes one after another.
+  std::map<uint64_t, Fragment> _unassembled_buffer = {};
+  uint64_t _runs = {}; // runs of touching fragments (each one an interval of held bytes)
+
+  // Limits on the runs and fragments held (Engine::Map), and what was evicted to stay within them
+  uint64_t _max_fragments = default_max_fragments;
+  uint64_t _max_overhead_bytes = default_max_overhead_bytes;
+  bool _default_limits = true; // until set_limits(), the limits follow the stream's capacity
+  uint64_t _overhead_bytes = {};
+  uint64_t _fragments_evicted = {};
+  uint64_t _bytes_evicted = {};
+
+  bool _check_str( uint64_t& first_index, Buffer& data, const Writer& output ) const;
+  void _push_str( Buffer& data, Writer& output );
 
   // Helper function for unassembled buffer
-  bool _buffer_empty();
-  void _buffer_update();
-  void _buffer_insert( uint64_t first_index, std::string& data );
-  std::optional<ReassemblerBuffer> _buffer_peak();
-  void _buffer_pop();
+  void _buffer_insert( uint64_t first_index, Buffer& data, uint64_t pinned );
+  void _buffer_erase( std::map<uint64_t, Fragment>::iterator it );
+  static Fragment _coalesced( Fragment front, const Fragment& back );
+  uint64_t _buffer_touching( std::map<uint64_t, Fragment>::const_iterator it ) const;
+  void _buffer_evict();
+  void _buffer_drain( Writer& output );
+
+  // Engine::Bitmap: byte i of the stream is held at _ring[i % _ring.size()] while bit i % _ring.size()
+  // of _present is set. Every held byte lies in [_unassembled_index, _unassembled_index + capacity),
+  // so no two of them share a slot. Both are allocated on the first out-of-order insert.
+  std::string _ring = {};
+  std::vector<uint64_t> _present = {};
+  std::vector<std::span<char>> _drain_spans = {}; // the stream's space for a drain, kept to reuse
+
+  // Helper function for the bitmap engine
+  void _bitmap_insert( uint64_t first_index, std::string_view data, const Writer& output );
+  void _bitmap_clear( uint64_t first_index, uint64_t len );
+  void _bitmap_drain( Writer& output );
 
 public:
+  // Bookkeeping bytes per held fragment (on top of any of its Buffer's bytes outside the slice)
+  static constexpr uint64_t fragment_overhead = sizeof( std::pair<const uint64_t, Fragment> ) + 4 * sizeof( void* );
+
+  // A slice this small is copied onto the fragment it continues, if that one is a copy already or they
+  // are this small together
+  static constexpr uint64_t coalesce_limit = 1024;
+
+  static constexpr uint64_t default_max_fragments = 4096;
+  static constexpr uint64_t default_max_overhead_bytes = 1 << 20;
+
+  explicit Reassembler( Engine engine = Engine::Map ) : _engine( engine ) {}
+
+  /*
+   * Bound what the map engine holds: how many fragments (a run of touching fragments counts once, as
+   * in-order data behind a hole would otherwise count per segment), and how many bytes of overhead (the
+   * fragments' bookkeeping, plus the bytes of their Buffers outside the slices they keep). A peer that sends many
+   * tiny out-of-order segments would otherwise make the Reassembler hold far more memory than it holds
+   * data. Going over a limit evicts the fragments furthest from the next byte needed first; their bytes
+   * have to be sent again. (The bitmap engine's memory is fixed, so the limits don't apply to it.)
+   *
+   * By default the limits grow with the stream's capacity, to one run per `fragment_overhead` bytes and
+   * one byte of overhead per byte: segments of at least `fragment_overhead` bytes never cause eviction.
+   */
+  void set_limits( uint64_t max_fragments, uint64_t max_overhead_bytes );
+
   /*
    * Insert a new substring to be reassembled into a ByteStream.
    *   `first_index`: the index of the first byte of the substring
-   *   `data`: the substring itself
+   *   `data`: the substring itself (held as a slice of the Buffer, not a copy, until it can be written)
    *   `is_last_substring`: this substring represents the end of the stream
    *   `output`: a mutable reference to the Writer
    *
@@ -47,8 +120,15 @@ public:
    *
    * The Reassembler should close the stream after writing the last byte.
    */
-  void insert( uint64_t first_index, std::string data, bool is_last_substring, Writer& output );
+  void insert( uint64_t first_index, Buffer data, bool is_last_substring, Writer& output );
 
   // How many bytes are stored in the Reassembler itself?
   uint64_t bytes_pending() const;
+
+  // The intervals [first, end) of stream indices held, lowest first: at most `max_count` of them
+  std::vector<std::pair<uint64_t, uint64_t>> held_intervals( size_t max_count = SIZE_MAX ) const;
+
+  // How many fragments, and bytes in them, have been evicted to stay within the limits?
+  uint64_t fragments_evicted() const { return _fragments_evicted; }
+  uint64_t bytes_evicted() const { return _bytes_evicted; }
 };
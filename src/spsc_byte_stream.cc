@@ -0,0 +1,120 @@
+#include "spsc_byte_stream.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+SPSCByteStream::SPSCByteStream( uint64_t capacity )
+  : capacity_( capacity ), ring_( make_unique<char[]>( capacity ) ) // NOLINT(*-avoid-c-arrays)
+{}
+
+uint64_t SPSCByteStream::push( string_view data )
+{
+  const uint64_t pushed = bytes_pushed_.load( memory_order_relaxed );
+  const uint64_t len = min<uint64_t>( data.size(), available_capacity() );
+  if ( len == 0 ) {
+    return 0;
+  }
+
+  const uint64_t tail = pushed % capacity_;
+  const uint64_t first = min( len, capacity_ - tail );
+  copy_n( data.data(), first, ring_.get() + tail );
+  copy_n( data.data() + first, len - first, ring_.get() );
+
+  bytes_pushed_.store( pushed + len ); // publishes the bytes
+
+  // Wake the consumer if it may have seen an empty stream. Both sides store their own counter
+  // and then load the other's (sequentially consistent), so at least one of them notices the other.
+  if ( bytes_popped_.load() == pushed ) {
+    readable_.notify();
+  }
+  return len;
+}
+
+void SPSCByteStream::close()
+{
+  closed_.store( true );
+  readable_.notify();
+}
+
+void SPSCByteStream::set_error()
+{
+  errored_.store( true );
+  readable_.notify();
+  writable_.notify();
+}
+
+bool SPSCByteStream::is_closed() const
+{
+  return closed_.load();
+}
+
+uint64_t SPSCByteStream::available_capacity() const
+{
+  // loading bytes_popped_ also acquires the consumer's reads of the space it freed
+  return capacity_ - ( bytes_pushed_.load( memory_order_relaxed ) - bytes_popped_.load() );
+}
+
+uint64_t SPSCByteStream::bytes_pushed() const
+{
+  return bytes_pushed_.load( memory_order_relaxed );
+}
+
+string_view SPSCByteStream::peek() const
+{
+  const uint64_t buffered = bytes_buffered();
+  const uint64_t head = bytes_popped_.load( memory_order_relaxed ) % max<uint64_t>( capacity_, 1 );
+  return { ring_.get() + head, min( buffered, capacity_ - head ) };
+}
+
+vector<string_view> SPSCByteStream::peek_all() const
+{
+  vector<string_view> views;
+  const uint64_t buffered = bytes_buffered();
+  const string_view first = peek();
+  if ( not first.empty() ) {
+    views.push_back( first );
+  }
+  if ( first.size() < buffered ) {
+    views.emplace_back( ring_.get(), buffered - first.size() );
+  }
+  return views;
+}
+
+void SPSCByteStream::pop( uint64_t len )
+{
+  const uint64_t popped = bytes_popped_.load( memory_order_relaxed );
+  len = min( len, bytes_buffered() );
+  if ( len == 0 ) {
+    return;
+  }
+
+  bytes_popped_.store( popped + len ); // hands the space back to the producer
+
+  // Wake the producer if it may have seen a full stream (see push).
+  if ( bytes_pushed_.load() == popped + capacity_ ) {
+    writable_.notify();
+  }
+}
+
+bool SPSCByteStream::is_finished() const
+{
+  // check closed first: a push can't follow the close, so an empty stream after it is final
+  return closed_.load() and bytes_buffered() == 0;
+}
+
+bool SPSCByteStream::has_error() const
+{
+  return errored_.load();
+}
+
+uint64_t SPSCByteStream::bytes_buffered() const
+{
+  // loading bytes_pushed_ also acquires the producer's writes of those bytes
+  return bytes_pushed_.load() - bytes_popped_.load( memory_order_relaxed );
+}
+
+uint64_t SPSCByteStream::bytes_popped() const
+{
+  return bytes_popped_.load( memory_order_relaxed );
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "eventfd.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/*
+ * A ByteStream that one producer thread and one consumer thread can use at the same time, without locks.
+ *
+ * The producer calls only the Writer-side methods (push, close, set_error, available_capacity,
+ * bytes_pushed, is_closed) and the consumer only the Reader-side methods (peek, peek_all, pop,
+ * is_finished, has_error, bytes_buffered, bytes_popped). The bytes live in a ring of `capacity`
+ * bytes; the two cumulative counters that delimit it are each written by only one side, and sit on
+ * separate cache lines so the two threads don't contend for them.
+ *
+ * Each side can sleep in an EventLoop: `readable_event()` fires when a push or close gives
+ * the consumer something to do, and `writable_event()` fires when a pop frees space in a full stream.
+ */
+class SPSCByteStream
+{
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  uint64_t capacity_;
+  std::unique_ptr<char[]> ring_;
+
+  alignas( CACHE_LINE_SIZE ) std::atomic<uint64_t> bytes_pushed_ {}; // written by the producer only
+  alignas( CACHE_LINE_SIZE ) std::atomic<uint64_t> bytes_popped_ {}; // written by the consumer only
+  alignas( CACHE_LINE_SIZE ) std::atomic<bool> closed_ {};
+  std::atomic<bool> errored_ {};
+
+  EventFD readable_ {};
+  EventFD writable_ {};
+
+public:
+  explicit SPSCByteStream( uint64_t capacity );
+
+  // Producer side
+  uint64_t push( std::string_view data ); // Push as much of data as fits; returns the number of bytes pushed.
+  void close();                           // Signal that the stream has reached its ending.
+  void set_error();                       // Signal that the stream suffered an error.
+  bool is_closed() const;
+  uint64_t available_capacity() const;
+  uint64_t bytes_pushed() const;
+
+  // Consumer side
+  std::string_view peek() const;                  // contiguous bytes up to the wrap point
+  std::vector<std::string_view> peek_all() const; // every buffered byte, at most two views
+  void pop( uint64_t len );
+  bool is_finished() const;
+  bool has_error() const;
+  uint64_t bytes_buffered() const;
+  uint64_t bytes_popped() const;
+
+  // Wakeups for the other side's EventLoop (the callback should call clear() before draining the stream)
+  EventFD& readable_event() { return readable_; }
+  EventFD& writable_event() { return writable_; }
+
+  // Not copyable or movable: both threads hold references to it
+  SPSCByteStream( const SPSCByteStream& other ) = delete;
+  SPSCByteStream& operator=( const SPSCByteStream& other ) = delete;
+  SPSCByteStream( SPSCByteStream&& other ) = delete;
+  SPSCByteStream& operator=( SPSCByteStream&& other ) = delete;
+  ~SPSCByteStream() = default;
+};
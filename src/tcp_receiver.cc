@@ -18,6 +18,8 @@ void TCPReceiver::receive( TCPSenderMessage message, Reassembler& reassembler, W
     _next_abs_seqno = 0;
     _next_stream_index = 0;
     _last_bytes_pushed = 0;
+    _ts_recent.reset();
+    _recent_held.clear();
   }
 
   // Begin with sync
@@ -25,7 +27,16 @@ void TCPReceiver::receive( TCPSenderMessage message, Reassembler& reassembler, W
     return;
   }
 
+  if ( is_old_duplicate( message ) ) {
+    return;
+  }
+
   const uint64_t next_seqno = message.seqno.unwrap( _initial_seqno, _next_abs_seqno );
+
+  // the timestamp to echo is the one of the segment that starts at (or before) the ackno
+  if ( message.tsval.has_value() && next_seqno <= _next_abs_seqno ) {
+    _ts_recent = message.tsval;
+  }
   // Push data thats (partially) inside the window size.
   if ( next_seqno + message.sequence_length() > _next_abs_seqno
        || next_seqno < _next_abs_seqno + inbound_stream.available_capacity() ) {
@@ -36,7 +47,17 @@ void TCPReceiver::receive( TCPSenderMessage message, Reassembler& reassembler, W
     if ( message.SYN ) {
       stream_index = 0;
     }
-    reassembler.insert( stream_index, message.payload, message.FIN, inbound_stream );
+    const bool has_payload = not message.payload.empty();
+    reassembler.insert( stream_index, move( message.payload ), message.FIN, inbound_stream );
+
+    // remember where data went to the Reassembler rather than the stream, for the order of the SACK blocks
+    if ( has_payload and stream_index > inbound_stream.bytes_pushed() ) {
+      erase( _recent_held, stream_index );
+      _recent_held.push_front( stream_index );
+      if ( _recent_held.size() > TCPReceiverMessage::MAX_SACK_BLOCKS ) {
+        _recent_held.pop_back();
+      }
+    }
   }
 
   // Reset for next connect
@@ -53,13 +74,54 @@ void TCPReceiver::receive( TCPSenderMessage message, Reassembler& reassembler, W
   _next_abs_seqno = _next_stream_index + 1 + !_synced;
 }
 
+bool TCPReceiver::is_old_duplicate( const TCPSenderMessage& message ) const
+{
+  // (its seqno may have wrapped around since, and look acceptable)
+  return _synced && message.tsval.has_value() && _ts_recent.has_value()
+         && static_cast<int32_t>( message.tsval.value() - _ts_recent.value() ) < 0;
+}
+
 TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream ) const
 {
   std::optional<Wrap32> ack_seqno = {};
-  const uint64_t size = std::min( inbound_stream.available_capacity(), 65535UL );
+  const uint64_t size = std::min( inbound_stream.available_capacity() >> _window_shift, 65535UL );
 
   if ( _next_abs_seqno > 0 ) {
     ack_seqno = Wrap32::wrap( _next_abs_seqno, _initial_seqno );
   }
-  return TCPReceiverMessage { ack_seqno, static_cast<uint16_t>( size ) };
+  TCPReceiverMessage message { ack_seqno, static_cast<uint16_t>( size ) };
+  message.tsecr = _ts_recent;
+  return message;
+}
+
+TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream, const Reassembler& reassembler ) const
+{
+  TCPReceiverMessage message = send( inbound_stream );
+  if ( not message.ackno.has_value() ) {
+    return message;
+  }
+
+  const auto held = reassembler.held_intervals();
+  vector<bool> reported( held.size() );
+  const auto report = [&]( size_t i ) {
+    if ( reported[i] or message.sack_blocks.size() == TCPReceiverMessage::MAX_SACK_BLOCKS ) {
+      return;
+    }
+    reported[i] = true;
+    // stream index i is absolute seqno i + 1 (after the SYN)
+    message.sack_blocks.push_back(
+      { Wrap32::wrap( held[i].first + 1, _initial_seqno ), Wrap32::wrap( held[i].second + 1, _initial_seqno ) } );
+  };
+
+  // the blocks holding the latest segments first (those since drained to the stream, or evicted, hold nothing)
+  for ( const uint64_t index : _recent_held ) {
+    const auto it = ranges::upper_bound( held, index, {}, []( const auto& interval ) { return interval.first; } );
+    if ( it != held.begin() and index < prev( it )->second ) {
+      report( prev( it ) - held.begin() );
+    }
+  }
+  for ( size_t i = 0; i < held.size(); i++ ) {
+    report( i );
+  }
+  return message;
 }
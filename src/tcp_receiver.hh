@@ -4,6 +4,9 @@
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
+#include <deque>
+#include <optional>
+
 class TCPReceiver
 {
 private:
@@ -12,6 +15,9 @@ private:
   uint64_t _next_abs_seqno {};
   uint64_t _next_stream_index {};
   uint64_t _last_bytes_pushed {};
+  uint8_t _window_shift {}; // advertised windows are in units of 2^_window_shift bytes (RFC 7323)
+  std::optional<uint32_t> _ts_recent {}; // the latest in-sequence TSval, to echo (RFC 7323)
+  std::deque<uint64_t> _recent_held {};  // stream indices of the latest segments held out of order, newest first
 
 public:
   /*
@@ -20,6 +26,22 @@ public:
    */
   void receive( TCPSenderMessage message, Reassembler& reassembler, Writer& inbound_stream );
 
+  /*
+   * PAWS (RFC 7323): is this an old duplicate, stamped earlier than a segment already received in sequence?
+   * Such a segment is dropped whole (its ack and window too), even if its seqno looks acceptable.
+   */
+  bool is_old_duplicate( const TCPSenderMessage& message ) const;
+
+  /* Advertise windows scaled down by 2^shift (once both SYNs have carried the window scale option). */
+  void set_window_shift( uint8_t shift ) { _window_shift = shift; }
+
   /* The TCPReceiver sends TCPReceiverMessages back to the TCPSender. */
   TCPReceiverMessage send( const Writer& inbound_stream ) const;
+
+  /*
+   * The same, also reporting (as SACK blocks) what the Reassembler holds beyond the ackno. The block holding
+   * the latest segment received out of order goes first, then the ones holding the segments before it, then
+   * the rest lowest first (RFC 2018 section 4).
+   */
+  TCPReceiverMessage send( const Writer& inbound_stream, const Reassembler& reassembler ) const;
 };
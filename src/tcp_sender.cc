@@ -2,7 +2,9 @@
 #include "tcp_config.hh"
 
 #include <algorithm>
+#include <cmath>
 #include <random>
+#include <vector>
 #include <stop_token>
 
 using namespace std;
@@ -15,6 +17,51 @@ TCPSender::TCPSender( uint64_t initial_RTO_ms, optional<Wrap32> fixed_isn )
   , _current_RTO_ms( initial_RTO_ms )
 {}
 
+TCPSender::TCPSender( const TCPConfig& config )
+  : TCPSender( config.rt_timeout, config.fixed_isn )
+{
+  _mss = max<uint64_t>( config.mss, 1 );
+  _congestion_control = CongestionControl { config.congestion_control, _mss };
+  _fast_retransmit = config.fast_retransmit;
+  _window_scaling = config.window_scaling;
+  _timestamps = config.timestamps;
+  _estimate_rtt = config.rtt_estimation;
+  if ( _estimate_rtt ) {
+    _min_RTO_ms = config.rto_min_ms;
+    _max_RTO_ms = config.rto_max_ms;
+  }
+}
+
+void RTTEstimator::add_sample( uint64_t rtt_ms )
+{
+  const auto rtt = static_cast<double>( rtt_ms );
+  if ( !_measured ) {
+    _srtt_ms = rtt;
+    _rttvar_ms = rtt / 2;
+    _measured = true;
+    return;
+  }
+
+  // alpha = 1/8, beta = 1/4 (RTTVAR is updated with the SRTT from before this sample)
+  _rttvar_ms = 0.75 * _rttvar_ms + 0.25 * std::abs( _srtt_ms - rtt );
+  _srtt_ms = 0.875 * _srtt_ms + 0.125 * rtt;
+}
+
+uint64_t RTTEstimator::rto_ms( uint64_t min_ms, uint64_t max_ms ) const
+{
+  // the clock granularity G is a millisecond: the tick
+  const double rto = _srtt_ms + std::max( 1.0, 4 * _rttvar_ms );
+  return std::clamp( static_cast<uint64_t>( std::ceil( rto ) ), min_ms, max_ms );
+}
+
+uint64_t TCPSender::_base_RTO_ms() const
+{
+  if ( _estimate_rtt && _rtt.measured() ) {
+    return _rtt.rto_ms( _min_RTO_ms, _max_RTO_ms );
+  }
+  return initial_RTO_ms_;
+}
+
 void Timer::start_timer( uint64_t threshold_ms )
 {
   if ( _current_ms == 0 ) {
@@ -40,9 +87,16 @@ void Timer::stop_timer()
 
 uint64_t TCPSender::_get_avaliable_size( bool& syn, Reader& outbound_stream, bool& fin )
 {
-  uint64_t available_num = std::min( outbound_stream.bytes_buffered(), TCPConfig::MAX_PAYLOAD_SIZE );
+  // the MSS counts the options too (but a payload of at least a byte goes out)
+  const uint64_t max_payload = _mss > _options_length ? _mss - _options_length : 1;
+  uint64_t available_num = std::min( outbound_stream.bytes_buffered(), max_payload );
   uint64_t window_num = _window_size;
 
+  // the congestion window limits what's in flight too (but doesn't stop zero-window probes)
+  if ( window_num > 0 ) {
+    window_num = std::min( window_num, std::max<uint64_t>( _congestion_control.cwnd(), 1 ) );
+  }
+
   // Pretend the window size is one, only after window size is set
   if ( !_attempted && _received && window_num == 0 ) {
     window_num = 1;
@@ -87,31 +141,66 @@ uint64_t TCPSender::consecutive_retransmissions() const
 
 optional<TCPSenderMessage> TCPSender::maybe_send()
 {
-  TCPSenderMessage msg;
+  // retransmissions go ahead of new data (skipping any acknowledged meanwhile)
+  while ( !_retransmit_seqnos.empty() ) {
+    const uint64_t seqno = _retransmit_seqnos.front();
+    const auto it = _outstanding_from( seqno );
+    _retransmit_seqnos.pop_front();
+    if ( it != _retransmission_queue.end() && it->seqno == seqno ) {
+      it->resent = true;
+      return _stamped( it->message );
+    }
+  }
 
   if ( _send_queue.empty() ) {
     return {};
   }
 
-  msg = _send_queue.front();
+  // segments go out in seqno order, so the queue stays sorted
+  const uint64_t seqno = _send_queue.front().seqno.unwrap( isn_, _next_abs_seqno );
+  _retransmission_queue.push_back( Outstanding { seqno, std::move( _send_queue.front() ), _now_ms } );
   _send_queue.pop_front();
-  _retransmission_queue.push( msg );
+  return _stamped( _retransmission_queue.back().message );
+}
+
+TCPSenderMessage TCPSender::_stamped( TCPSenderMessage msg ) const
+{
+  if ( _timestamps ) {
+    msg.tsval = _timestamp();
+  }
   return msg;
 }
 
+deque<TCPSender::Outstanding>::iterator TCPSender::_outstanding_from( uint64_t seqno )
+{
+  return lower_bound( _retransmission_queue.begin(),
+                      _retransmission_queue.end(),
+                      seqno,
+                      []( const Outstanding& segment, uint64_t value ) { return segment.seqno < value; } );
+}
+
 void TCPSender::push( Reader& outbound_stream )
 {
   uint64_t num {};
-  std::string str {};
   bool syn {};
   bool fin {};
 
+  // the stream may still count acknowledged bytes against its capacity (Reader::retain_popped)
+  outbound_stream.release( _acked_payload );
+  _acked_payload = 0;
+
+  // holes waiting for room in the pipe come before new data
+  if ( _in_recovery || _after_timeout ) {
+    _retransmit_holes();
+  }
+
   num = _get_avaliable_size( syn, outbound_stream, fin );
   while ( num > 0 ) {
     TCPSenderMessage msg {};
 
-    read( outbound_stream, num, str );
-    msg.payload = str;
+    // with Paged or Chunked storage the payload is a slice of the stream's own storage, not a copy: the
+    // queues (and any retransmission) share those bytes until the segment is acknowledged
+    read( outbound_stream, num, msg.payload );
     msg.SYN = syn;
     msg.FIN = fin;
 
@@ -122,9 +211,9 @@ void TCPSender::push( Reader& outbound_stream )
     }
 
     msg.seqno = Wrap32::wrap( _next_abs_seqno, isn_ );
-    _send_queue.push_back( msg );
     _next_abs_seqno += msg.sequence_length();
     _outstanding_num += msg.sequence_length();
+    _send_queue.push_back( std::move( msg ) );
 
     _timer.start_timer( _current_RTO_ms );
 
@@ -137,14 +226,27 @@ TCPSenderMessage TCPSender::send_empty_message() const
   TCPSenderMessage msg {};
 
   msg.seqno = Wrap32::wrap( _next_abs_seqno, isn_ );
-  return msg;
+  return _stamped( msg );
 }
 
-void TCPSender::receive( const TCPReceiverMessage& msg )
+void TCPSender::receive( const TCPReceiverMessage& msg, bool carried_data )
 {
   _received = true;
   _attempted = false;
-  _window_size = msg.window_size;
+  const uint64_t window_size = uint64_t { msg.window_size } << _peer_window_shift;
+  const bool window_update = window_size != _window_size;
+  _window_size = window_size;
+
+  // the windows after the peer's SYN are scaled if both SYNs offered it (the SYN's own window never is)
+  if ( msg.window_scale.has_value() && _window_scaling && _next_abs_seqno <= 1 ) {
+    _peer_window_shift = min( msg.window_scale.value(), TCPConfig::MAX_WINDOW_SHIFT );
+  }
+
+  // the peer's SYN says how large a segment it takes: send no larger (decided before any data is sent)
+  if ( msg.mss.has_value() && msg.mss.value() < _mss && _next_abs_seqno <= 1 ) {
+    _mss = max<uint64_t>( msg.mss.value(), 1 );
+    _congestion_control.set_mss( _mss );
+  }
 
   if ( !msg.ackno.has_value() ) {
     return;
@@ -152,57 +254,259 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
 
   // check if ackno is valid
   const uint64_t ack_seq = msg.ackno.value().unwrap( isn_, _next_abs_seqno );
-  if ( ack_seq <= _ack_seqno.unwrap( isn_, _next_abs_seqno ) || ack_seq > _next_abs_seqno ) {
+  const uint64_t last_ack_seq = _ack_seqno.unwrap( isn_, _next_abs_seqno );
+  if ( ack_seq < last_ack_seq || ack_seq > _next_abs_seqno ) {
     return;
   }
 
-  // Some data is successfully received.
+  // A duplicate ackno can still carry news about the holes. It is a duplicate ACK (RFC 5681) only if
+  // something is outstanding, it doesn't update the window and its segment carried nothing else (the peer
+  // sending its own data repeats the ackno): each one is a segment of ours that left the network.
+  if ( ack_seq == last_ack_seq ) {
+    if ( _outstanding_num > 0 && !window_update && !carried_data ) {
+      // (with SACK information, the pipe estimate takes the place of NewReno's window inflation)
+      const bool inflate = msg.sack_blocks.empty();
+      if ( _in_recovery && inflate ) {
+        _congestion_control.on_dup_ack();
+      } else if ( !_in_recovery && !_after_timeout && _fast_retransmit && ++_dup_acks == DUP_THRESH ) {
+        // fast retransmit, and fast recovery with the duplicates so far already counted
+        _begin_recovery();
+        for ( uint64_t i = 0; inflate && i < DUP_THRESH; i++ ) {
+          _congestion_control.on_dup_ack();
+        }
+        _retransmit_first();
+      }
+    }
+    _update_scoreboard( msg, ack_seq );
+    return;
+  }
+
+  // Some data is successfully received. (The window only grows outside loss recovery.)
   _ack_seqno = msg.ackno.value();
+  _dup_acks = 0;
+  if ( !_in_recovery ) {
+    _congestion_control.on_ack( ack_seq - last_ack_seq, _now_ms );
+  }
 
+  optional<uint64_t> rtt_sample {};
+  bool repaired = false; // the ack covers a segment sent more than once, or SACKed before
   while ( !_retransmission_queue.empty() ) {
-    TCPSenderMessage message = _retransmission_queue.top();
-    const uint64_t seqno = message.seqno.unwrap( isn_, _next_abs_seqno );
+    const Outstanding& segment = _retransmission_queue.front();
+    const uint64_t length = segment.message.sequence_length();
 
     // Remove from the retransmission queue, if all sequence number are acknowledged.
-    if ( seqno + message.sequence_length() > ack_seq ) {
+    if ( segment.seqno + length > ack_seq ) {
       break;
     }
-    _retransmission_queue.pop();
-    _outstanding_num -= message.sequence_length();
+
+    // The most recently sent segment acknowledged gives the RTT sample. But an ack that repairs a hole
+    // (covering a retransmission, or data SACKed earlier) was held back by the loss: it gives none (Karn's rule).
+    repaired |= segment.resent || segment.sacked;
+    rtt_sample = _now_ms - segment.sent_ms;
+    _acked_payload += segment.message.payload.size();
+    _retransmission_queue.pop_front();
+    _outstanding_num -= length;
+  }
+  if ( repaired ) {
+    rtt_sample.reset();
+  }
+
+  // The echoed timestamp times this ack of new data, even for data sent more than once (RFC 7323 section 4.1).
+  // An echo of zero, or of a time in the future or older than the RTO, is no stamp of ours: it gives no sample.
+  const uint32_t echo = _timestamps ? msg.tsecr.value_or( 0 ) : 0;
+  const uint32_t echo_rtt = _timestamp() - echo;
+  if ( _estimate_rtt && echo != 0 && echo_rtt <= _current_RTO_ms ) {
+    _rtt.add_sample( echo_rtt );
+  } else if ( _estimate_rtt && rtt_sample.has_value() ) {
+    _rtt.add_sample( rtt_sample.value() );
   }
 
   // reset RTO threshold & timer
   _retransmission_cnt = 0;
-  _current_RTO_ms = initial_RTO_ms_;
+  _current_RTO_ms = _base_RTO_ms();
   _timer.stop_timer();
 
   // Restart timer
   if ( _outstanding_num != 0 ) {
     _timer.start_timer( _current_RTO_ms );
   }
+
+  // A partial ACK means the next segment was lost too (NewReno): send it without waiting for more duplicates
+  if ( _in_recovery && ack_seq >= _recovery_point ) {
+    _end_recovery();
+  } else if ( _in_recovery && msg.sack_blocks.empty() ) {
+    _congestion_control.on_partial_ack( ack_seq - last_ack_seq );
+    _retransmit_first();
+  }
+  if ( ack_seq >= _recovery_point ) {
+    _after_timeout = false;
+  }
+  _update_scoreboard( msg, ack_seq );
+}
+
+void TCPSender::_update_scoreboard( const TCPReceiverMessage& msg, uint64_t ack_seq )
+{
+  if ( msg.sack_blocks.empty() ) {
+    return;
+  }
+
+  // mark the segments that lie wholly inside a block (ignoring blocks outside what was sent)
+  for ( const auto& block : msg.sack_blocks ) {
+    const uint64_t left = block.left_edge.unwrap( isn_, _next_abs_seqno );
+    const uint64_t right = block.right_edge.unwrap( isn_, _next_abs_seqno );
+    if ( left >= right || left < ack_seq || right > _next_abs_seqno ) {
+      continue;
+    }
+
+    for ( auto it = _outstanding_from( left );
+          it != _retransmission_queue.end() && it->seqno + it->message.sequence_length() <= right;
+          ++it ) {
+      it->sacked = true;
+    }
+  }
+
+  _sack_recovery();
+}
+
+void TCPSender::_sack_recovery()
+{
+  // A segment is lost once DUP_THRESH segments, or (DUP_THRESH - 1) full segments' worth of bytes,
+  // above it have been SACKed. Walk down from the top, counting those.
+  const uint64_t lost_bytes_threshold = ( DUP_THRESH - 1 ) * _mss;
+  uint64_t sacked_above = 0;
+  uint64_t sacked_bytes_above = 0;
+  for ( auto segment = _retransmission_queue.rbegin(); segment != _retransmission_queue.rend(); ++segment ) {
+    if ( segment->sacked ) {
+      sacked_above++;
+      sacked_bytes_above += segment->message.sequence_length();
+    } else if ( sacked_above >= DUP_THRESH || sacked_bytes_above >= lost_bytes_threshold ) {
+      segment->lost = true;
+    }
+  }
+
+  // recovery starts when the first unacknowledged segment is lost, which goes again straight away
+  if ( !_in_recovery ) {
+    if ( _retransmission_queue.empty() || !_retransmission_queue.front().lost ) {
+      return;
+    }
+    if ( !_after_timeout ) {
+      _begin_recovery();
+      _retransmit_first();
+    }
+  }
+
+  _retransmit_holes();
+}
+
+void TCPSender::_retransmit_holes()
+{
+  // Send the other lost holes again (once per episode, lowest first) while the pipe stays under cwnd and
+  // the hole is within the window (RFC 6675). Acks drain the pipe, and then push() sends the next ones.
+  const uint64_t window_end = _ack_seqno.unwrap( isn_, _next_abs_seqno ) + max<uint64_t>( _window_size, 1 );
+  uint64_t pipe = _pipe();
+  for ( auto& segment : _retransmission_queue ) {
+    const uint64_t length = segment.message.sequence_length();
+    if ( pipe >= _congestion_control.cwnd() || segment.seqno + length > window_end ) {
+      break;
+    }
+    if ( segment.lost && !segment.retransmitted ) {
+      segment.retransmitted = true;
+      _retransmit_seqnos.push_back( segment.seqno );
+      pipe += length;
+    }
+  }
+}
+
+uint64_t TCPSender::_pipe() const
+{
+  // what is in the network: segments neither SACKed nor lost, and every retransmission
+  uint64_t pipe = 0;
+  for ( const auto& segment : _retransmission_queue ) {
+    if ( segment.sacked ) {
+      continue;
+    }
+    const uint64_t length = segment.message.sequence_length();
+    pipe += ( segment.lost ? 0 : length ) + ( segment.retransmitted ? length : 0 );
+  }
+  return pipe;
+}
+
+void TCPSender::_begin_recovery()
+{
+  _in_recovery = true;
+  _recovery_point = _next_abs_seqno;
+  _congestion_control.on_loss( _outstanding_num, _now_ms );
+}
+
+void TCPSender::_retransmit_first()
+{
+  if ( _retransmission_queue.empty() ) {
+    return;
+  }
+  Outstanding& segment = _retransmission_queue.front();
+  if ( !segment.sacked && !segment.retransmitted ) {
+    segment.retransmitted = true;
+    _retransmit_seqnos.push_back( segment.seqno );
+  }
+}
+
+void TCPSender::_end_recovery()
+{
+  _in_recovery = false;
+  _dup_acks = 0;
+  _congestion_control.on_recovery_end();
+  for ( auto& segment : _retransmission_queue ) {
+    segment.retransmitted = false;
+  }
+}
+
+void TCPSender::_reset_scoreboard()
+{
+  _retransmit_seqnos.clear();
+  for ( auto& segment : _retransmission_queue ) {
+    segment.sacked = false;
+    segment.lost = false;
+    segment.retransmitted = false;
+  }
 }
 
 void TCPSender::tick( const size_t ms_since_last_tick )
 {
   bool elapsed {};
-  TCPSenderMessage msg {};
+  bool syn {};
 
+  _now_ms += ms_since_last_tick;
   elapsed = _timer.update_timer( ms_since_last_tick );
   if ( !elapsed ) {
     return;
   }
 
-  // Retransmit data
+  // Retransmit data. A timeout also ends loss recovery, and forgets the scoreboard: the receiver may have
+  // dropped what it SACKed, and the next ACKs say what it still holds. With fast recovery on, everything
+  // outstanding is presumed lost, and goes again as cwnd allows, skipping whatever is SACKed meanwhile.
+  if ( _in_recovery ) {
+    _end_recovery();
+  }
+  _reset_scoreboard();
   if ( !_retransmission_queue.empty() ) {
-    msg = _retransmission_queue.top();
-    _send_queue.push_back( msg );
-    _retransmission_queue.pop();
+    for ( auto& segment : _retransmission_queue ) {
+      segment.lost = _fast_retransmit;
+    }
+    Outstanding& segment = _retransmission_queue.front();
+    syn = segment.message.SYN;
+    segment.lost = true;
+    segment.retransmitted = true;
+    _retransmit_seqnos.push_back( segment.seqno );
+    _congestion_control.on_timeout( _outstanding_num, _now_ms );
+    _dup_acks = 0;
+    _after_timeout = true;
+    _recovery_point = _next_abs_seqno;
   }
 
-  if ( msg.SYN || _window_size > 0 ) {
+  if ( syn || _window_size > 0 ) {
     _retransmission_cnt++;
     // slow down retransmission timer
-    _current_RTO_ms *= 2;
+    _current_RTO_ms = std::min( _current_RTO_ms * 2, _max_RTO_ms );
   }
 
   // Reset & restart the timer
@@ -1,10 +1,11 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 #include <deque>
-#include <queue>
 
 class Timer
 {
@@ -16,13 +17,19 @@ public:
   bool update_timer( uint64_t ms_since_last_tick );
 };
 
-struct cmp
+// Smoothed round-trip time and its variation, and the retransmission timeout they give (RFC 6298)
+class RTTEstimator
 {
-  bool operator()( const TCPSenderMessage& left, const TCPSenderMessage& right )
-  {
-    Wrap32 zero { 0 };
-    return left.seqno.unwrap( zero, 0 ) > right.seqno.unwrap( zero, 0 );
-  }
+  double _srtt_ms {};
+  double _rttvar_ms {};
+  bool _measured {};
+
+public:
+  void add_sample( uint64_t rtt_ms );
+  bool measured() const { return _measured; }
+  double srtt_ms() const { return _srtt_ms; }
+  double rttvar_ms() const { return _rttvar_ms; }
+  uint64_t rto_ms( uint64_t min_ms, uint64_t max_ms ) const;
 };
 
 class TCPSender
@@ -35,21 +42,86 @@ class TCPSender
   bool _received {};
   bool _attempted {};
   Wrap32 _ack_seqno;
-  uint16_t _window_size {};
+  uint64_t _window_size {}; // as scaled by the peer's window shift
   uint64_t _next_abs_seqno {};
   uint64_t _outstanding_num {};
+  uint64_t _acked_payload {}; // acknowledged since the last push(), which releases it from the stream
   uint64_t _retransmission_cnt {};
   std::deque<TCPSenderMessage> _send_queue {};
-  std::priority_queue<TCPSenderMessage, std::vector<TCPSenderMessage>, cmp> _retransmission_queue {};
   uint64_t _current_RTO_ms;
   Timer _timer {};
+  uint64_t _now_ms {}; // time passed to tick(), in total
+
+  // RTT estimation (off for the legacy constructor, which keeps the initial RTO)
+  bool _estimate_rtt {};
+  uint64_t _min_RTO_ms {};
+  uint64_t _max_RTO_ms = UINT64_MAX;
+  RTTEstimator _rtt {};
+
+  // Timestamps (RFC 7323): segments carry the tick clock as TSval, and acks echoing it are timed by it
+  bool _timestamps {};
+  uint32_t _timestamp() const { return static_cast<uint32_t>( _now_ms ); }
+  TCPSenderMessage _stamped( TCPSenderMessage msg ) const;
+
+  uint64_t _mss = TCPConfig::MAX_PAYLOAD_SIZE; // largest segment: our own, or the peer's MSS option if lower
+  uint64_t _options_length {};                  // of the TCP options segments carry, which the MSS includes
+  bool _window_scaling {};                      // we offer window scaling on our SYN
+  uint8_t _peer_window_shift {};                // the peer's windows are in units of 2^shift bytes
+  CongestionControl _congestion_control {};
+
+  // A segment that was sent and not yet acknowledged, and what the SACK scoreboard knows about it
+  struct Outstanding
+  {
+    uint64_t seqno {}; // absolute
+    TCPSenderMessage message;
+    uint64_t sent_ms {};   // when it was first sent
+    bool resent {};        // sent more than once, so its ack gives no RTT sample (Karn's rule)
+    bool sacked {};        // the receiver holds it (reported in a SACK block)
+    bool lost {};          // deemed lost, from what has been SACKed above it
+    bool retransmitted {}; // already sent again in this recovery episode
+  };
+
+  // Outstanding segments in seqno order (the order they are sent in), and the ones (by seqno) to send again
+  // before new data. Acks trim the front; selective retransmission finds segments by binary search.
+  std::deque<Outstanding> _retransmission_queue {};
+  std::deque<uint64_t> _retransmit_seqnos {};
+
+  // Loss recovery: entered when the first unacknowledged segment is deemed lost, by the SACK scoreboard
+  // (RFC 6675) or by DUP_THRESH duplicate ACKs (RFC 6582), and over once everything sent before then is
+  // acknowledged. A timeout ends it and resets the scoreboard; until what was sent before the timeout is
+  // acknowledged, holes still go again but no new episode starts (RFC 6675 section 5.1).
+  static constexpr uint64_t DUP_THRESH = 3;
+  bool _fast_retransmit {};
+  uint64_t _dup_acks {};
+  bool _in_recovery {};
+  bool _after_timeout {};
+  uint64_t _recovery_point {};
 
   uint64_t _get_avaliable_size( bool& syn, Reader& outbound_stream, bool& fin );
 
+  std::deque<Outstanding>::iterator _outstanding_from( uint64_t seqno ); // the first at or after `seqno`
+
+  void _update_scoreboard( const TCPReceiverMessage& msg, uint64_t ack_seq );
+  void _sack_recovery();
+  void _retransmit_holes();
+  uint64_t _pipe() const;
+  void _begin_recovery();
+  void _retransmit_first();
+  void _end_recovery();
+  void _reset_scoreboard();
+
+  uint64_t _base_RTO_ms() const; // the RTO before any backoff
+
 public:
-  /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
+  /* Construct TCP sender with given default RTO and possible ISN (no congestion control or fast retransmit) */
   TCPSender( uint64_t initial_RTO_ms, std::optional<Wrap32> fixed_isn );
 
+  /* Construct TCP sender from a TCPConfig: its RTO, ISN, congestion control and loss recovery */
+  explicit TCPSender( const TCPConfig& config );
+
+  /* Leave room for this many bytes of TCP options in each segment pushed from now on (RFC 6691) */
+  void set_options_length( uint64_t bytes ) { _options_length = bytes; }
+
   /* Push bytes from the outbound stream */
   void push( Reader& outbound_stream );
 
@@ -59,8 +131,11 @@ public:
   /* Generate an empty TCPSenderMessage */
   TCPSenderMessage send_empty_message() const;
 
-  /* Receive an act on a TCPReceiverMessage from the peer's receiver */
-  void receive( const TCPReceiverMessage& msg );
+  /*
+   * Receive an act on a TCPReceiverMessage from the peer's receiver. `carried_data` says the segment that
+   * brought it also carried data, a SYN or a FIN: then it is no duplicate ACK, whatever its ackno (RFC 5681).
+   */
+  void receive( const TCPReceiverMessage& msg, bool carried_data = false );
 
   /* Time has passed by the given # of milliseconds since the last time the tick() method was called. */
   void tick( uint64_t ms_since_last_tick );
@@ -68,4 +143,9 @@ public:
   /* Accessors for use in testing */
   uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
   uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+  uint64_t mss() const { return _mss; }                                // Largest segment sent, in bytes
+  uint64_t cwnd() const { return _congestion_control.cwnd(); }         // Congestion window, in bytes
+  uint64_t ssthresh() const { return _congestion_control.ssthresh(); } // Slow-start threshold, in bytes
+  uint64_t current_RTO_ms() const { return _current_RTO_ms; }          // Retransmission timeout, backoff included
+  const RTTEstimator& rtt() const { return _rtt; }                     // Smoothed RTT estimates
 };
@@ -0,0 +1,307 @@
+#include "byte_stream.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+/*
+ * ByteStream benchmark suite: sweeps storage, capacity, write size and read size (plus a set of
+ * many concurrent streams), and reports throughput, ns per operation (one push or one pop) and heap
+ * allocations per operation as JSON on stdout.
+ *
+ * usage: byte_stream_benchmark [--quick] [--baseline results.json] [--threshold percent]
+ *
+ * With --baseline, each configuration is compared against a previous run's JSON and the program
+ * fails if any throughput dropped by more than the threshold (default 10%).
+ */
+
+static uint64_t allocation_count = 0; // NOLINT(*-non-const-global-variables)
+
+// Count every heap allocation made by the process
+void* operator new( size_t size )
+{
+  ++allocation_count;
+  if ( void* ptr = malloc( size ) ) { // NOLINT(*-no-malloc)
+    return ptr;
+  }
+  throw bad_alloc {};
+}
+
+void operator delete( void* ptr ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc)
+}
+
+void operator delete( void* ptr, size_t /* size */ ) noexcept
+{
+  free( ptr ); // NOLINT(*-no-malloc)
+}
+
+namespace {
+
+struct Config
+{
+  ByteStream::Storage storage;
+  size_t streams;
+  size_t capacity;
+  size_t write_size;
+  size_t read_size;
+};
+
+struct Result
+{
+  Config config;
+  uint64_t bytes;
+  uint64_t ops;
+  double seconds;
+  uint64_t allocations;
+
+  double gigabits_per_second() const { return 8 * static_cast<double>( bytes ) / seconds / 1e9; }
+  double ns_per_op() const { return seconds * 1e9 / static_cast<double>( ops ); }
+  double allocs_per_op() const { return static_cast<double>( allocations ) / static_cast<double>( ops ); }
+};
+
+string storage_name( ByteStream::Storage storage )
+{
+  switch ( storage ) {
+    case ByteStream::Storage::Chunked:
+      return "chunked";
+    case ByteStream::Storage::Mirrored:
+      return "mirrored";
+    case ByteStream::Storage::Paged:
+      return "paged";
+    case ByteStream::Storage::Ring:
+      break;
+  }
+  return "ring";
+}
+
+string config_name( const Config& c )
+{
+  ostringstream name;
+  name << storage_name( c.storage ) << "/streams=" << c.streams << "/capacity=" << c.capacity
+       << "/write=" << c.write_size << "/read=" << c.read_size;
+  return name.str();
+}
+
+Result run( const Config& c, size_t total_bytes )
+{
+  // Prepare every write up front, so only the ByteStream's own work is timed and counted
+  default_random_engine rd { 789 };
+  uniform_int_distribution<char> ud;
+  string pattern;
+  for ( size_t i = 0; i < c.write_size; ++i ) {
+    pattern += ud( rd );
+  }
+  const size_t writes_per_stream = max<size_t>( total_bytes / c.streams / c.write_size, 1 );
+  vector<vector<string>> writes( c.streams, vector<string>( writes_per_stream, pattern ) );
+
+  vector<ByteStream> streams;
+  streams.reserve( c.streams );
+  for ( size_t i = 0; i < c.streams; ++i ) {
+    streams.emplace_back( c.capacity, c.storage );
+  }
+  vector<size_t> next_write( c.streams );
+
+  uint64_t ops = 0;
+  uint64_t bytes_read = 0;
+  size_t finished = 0;
+
+  const uint64_t allocations_before = allocation_count;
+  const auto start_time = steady_clock::now();
+
+  while ( finished < c.streams ) {
+    for ( size_t i = 0; i < c.streams; ++i ) {
+      ByteStream& bs = streams[i];
+      if ( bs.reader().is_finished() ) {
+        continue;
+      }
+
+      if ( next_write[i] < writes_per_stream ) {
+        if ( bs.writer().available_capacity() >= c.write_size ) {
+          bs.writer().push( move( writes[i][next_write[i]++] ) );
+          ++ops;
+        }
+      } else if ( not bs.writer().is_closed() ) {
+        bs.writer().close();
+      }
+
+      if ( bs.reader().bytes_buffered() ) {
+        const auto peeked = bs.reader().peek().substr( 0, c.read_size );
+        bytes_read += peeked.size();
+        bs.reader().pop( peeked.size() );
+        ++ops;
+      }
+
+      finished += bs.reader().is_finished();
+    }
+  }
+
+  const auto stop_time = steady_clock::now();
+  const uint64_t allocations = allocation_count - allocations_before;
+
+  const uint64_t bytes_written = writes_per_stream * c.write_size * c.streams;
+  if ( bytes_read != bytes_written ) {
+    throw runtime_error( config_name( c ) + ": read " + to_string( bytes_read ) + " bytes but wrote "
+                         + to_string( bytes_written ) );
+  }
+
+  return { c,
+           bytes_written,
+           ops,
+           duration_cast<duration<double>>( stop_time - start_time ).count(),
+           allocations };
+}
+
+vector<Config> sweep( bool quick )
+{
+  vector<Config> configs;
+  const vector<ByteStream::Storage> storages = { ByteStream::Storage::Ring,
+                                                 ByteStream::Storage::Chunked,
+                                                 ByteStream::Storage::Mirrored,
+                                                 ByteStream::Storage::Paged };
+  const vector<size_t> capacities = quick ? vector<size_t> { 65536 } : vector<size_t> { 4096, 65536, 1 << 20 };
+  const vector<size_t> write_sizes = quick ? vector<size_t> { 1500 } : vector<size_t> { 16, 1500, 65536 };
+  const vector<size_t> read_sizes = quick ? vector<size_t> { 128 } : vector<size_t> { 16, 1500, 65536 };
+
+  for ( const auto storage : storages ) {
+    for ( const auto capacity : capacities ) {
+      for ( const auto write_size : write_sizes ) {
+        for ( const auto read_size : read_sizes ) {
+          if ( write_size <= capacity ) {
+            configs.push_back( { storage, 1, capacity, write_size, read_size } );
+          }
+        }
+      }
+    }
+
+    // many concurrent streams, as with many TCP connections
+    configs.push_back( { storage, quick ? 64UL : 256UL, 65536, 1500, 1500 } );
+  }
+
+  return configs;
+}
+
+void print_json( ostream& out, const vector<Result>& results )
+{
+  out << "{\n  \"benchmark\": \"byte_stream\",\n  \"results\": [\n";
+  for ( size_t i = 0; i < results.size(); ++i ) {
+    const Result& r = results[i];
+    out << "    {\"name\": \"" << config_name( r.config ) << "\", \"storage\": \""
+        << storage_name( r.config.storage ) << "\", \"streams\": " << r.config.streams << ", \"capacity\": "
+        << r.config.capacity << ", \"write_size\": " << r.config.write_size << ", \"read_size\": "
+        << r.config.read_size << ", \"bytes\": " << r.bytes << ", \"ops\": " << r.ops << fixed << setprecision( 3 )
+        << ", \"gbit_per_s\": " << r.gigabits_per_second() << ", \"ns_per_op\": " << r.ns_per_op()
+        << ", \"allocs_per_op\": " << r.allocs_per_op() << "}" << ( i + 1 < results.size() ? "," : "" ) << "\n";
+  }
+  out << "  ]\n}\n";
+}
+
+// Read the throughput of each configuration from a previous run's JSON (as printed above)
+map<string, double> read_baseline( const string& filename )
+{
+  ifstream file { filename };
+  if ( not file ) {
+    throw runtime_error( "could not open baseline " + filename );
+  }
+
+  map<string, double> baseline;
+  const string name_key = "\"name\": \"";
+  const string gbps_key = "\"gbit_per_s\": ";
+  string line;
+  while ( getline( file, line ) ) {
+    const auto name_pos = line.find( name_key );
+    const auto gbps_pos = line.find( gbps_key );
+    if ( name_pos == string::npos or gbps_pos == string::npos ) {
+      continue;
+    }
+    const auto name_start = name_pos + name_key.size();
+    const string name = line.substr( name_start, line.find( '"', name_start ) - name_start );
+    baseline[name] = stod( line.substr( gbps_pos + gbps_key.size() ) );
+  }
+  return baseline;
+}
+
+// Returns the number of configurations that regressed by more than `threshold_percent`
+size_t compare( const vector<Result>& results, const map<string, double>& baseline, double threshold_percent )
+{
+  size_t regressions = 0;
+  for ( const auto& r : results ) {
+    const auto it = baseline.find( config_name( r.config ) );
+    if ( it == baseline.end() ) {
+      continue;
+    }
+    const double change = ( r.gigabits_per_second() / it->second - 1 ) * 100;
+    const bool regressed = change < -threshold_percent;
+    regressions += regressed;
+    cerr << ( regressed ? "REGRESSION " : "           " ) << config_name( r.config ) << ": " << fixed
+         << setprecision( 2 ) << it->second << " -> " << r.gigabits_per_second() << " Gbit/s (" << showpos
+         << change << noshowpos << "%)\n";
+  }
+  return regressions;
+}
+
+void program_body( const vector<string_view>& args )
+{
+  bool quick = false;
+  string baseline_file;
+  double threshold_percent = 10;
+
+  for ( size_t i = 0; i < args.size(); ++i ) {
+    if ( args[i] == "--quick" ) {
+      quick = true;
+    } else if ( args[i] == "--baseline" and i + 1 < args.size() ) {
+      baseline_file = args[++i];
+    } else if ( args[i] == "--threshold" and i + 1 < args.size() ) {
+      threshold_percent = stod( string { args[++i] } );
+    } else {
+      throw runtime_error(
+        "usage: byte_stream_benchmark [--quick] [--baseline results.json] [--threshold percent]" );
+    }
+  }
+
+  const size_t total_bytes = quick ? 1 << 25 : 1 << 27;
+  vector<Result> results;
+  for ( const auto& config : sweep( quick ) ) {
+    results.push_back( run( config, total_bytes ) );
+    cerr << config_name( config ) << ": " << fixed << setprecision( 2 ) << results.back().gigabits_per_second()
+         << " Gbit/s\n";
+  }
+
+  print_json( cout, results );
+
+  if ( not baseline_file.empty() ) {
+    const size_t regressions = compare( results, read_baseline( baseline_file ), threshold_percent );
+    if ( regressions ) {
+      throw runtime_error( to_string( regressions ) + " configuration(s) regressed by more than "
+                           + to_string( threshold_percent ) + "%" );
+    }
+  }
+}
+
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  try {
+    program_body( { argv + 1, argv + argc } );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -97,6 +97,38 @@ int main()
       test.execute( BytesBuffered { 1 } );
     }
 
+    for ( const auto storage : { ByteStream::Storage::Ring,
+                                  ByteStream::Storage::Chunked,
+                                  ByteStream::Storage::Mirrored,
+                                  ByteStream::Storage::Paged } ) {
+      ByteStreamTestHarness test { "popping everything leaves a reservation in place", 8, storage };
+      test.execute( Push { "abc" } );
+      test.execute( Pop { 1 } );
+      test.execute( PushReserved { "def" }.popping( 2 ) );
+      test.execute( BytesBuffered { 3 } );
+      test.execute( ReadAll( "def" ) );
+      test.execute( PushReserved { "gh" } );
+      test.execute( ReadAll( "gh" ) );
+    }
+
+    {
+      ByteStreamTestHarness test { "retained bytes hold capacity until released", 4 };
+      test.execute( RetainPopped {} );
+      test.execute( Push { "cat" } );
+      test.execute( Pop { 2 } );
+      test.execute( BytesBuffered { 1 } );
+      test.execute( BytesRetained { 2 } );
+      test.execute( AvailableCapacity { 1 } );
+      test.execute( Push { "so" } );
+      test.execute( BytesBuffered { 2 } );
+      test.execute( Peek { "ts" } );
+      test.execute( Release { 1 } );
+      test.execute( AvailableCapacity { 1 } );
+      test.execute( Release { 5 } );
+      test.execute( BytesRetained { 0 } );
+      test.execute( AvailableCapacity { 2 } );
+    }
+
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
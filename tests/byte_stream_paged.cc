@@ -0,0 +1,99 @@
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+struct PoolInUse : public ExpectNumber<ByteStream, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "BufferPool::global().in_use()"; }
+  size_t value( ByteStream& /* bs */ ) const override { return BufferPool::global().in_use(); }
+};
+
+int main()
+{
+  constexpr uint64_t page = BufferPool::page_size;
+  const string one_page( page, 'x' );
+
+  try {
+    {
+      ByteStreamTestHarness test { "idle stream holds no pages", 4 * page, ByteStream::Storage::Paged };
+
+      test.execute( PoolInUse { 0 } );
+      test.execute( Push { "cat" } );
+      test.execute( PoolInUse { page } );
+      test.execute( AvailableCapacity { 4 * page - 3 } );
+      test.execute( Push { one_page } );
+      test.execute( PoolInUse { 2 * page } );
+      test.execute( Pop { 3 } );
+      test.execute( PoolInUse { 2 * page } );
+      test.execute( Peek { one_page } );
+      test.execute( Pop { page } );
+      test.execute( PoolInUse { 0 } );
+      test.execute( AvailableCapacity { 4 * page } );
+    }
+
+    {
+      BufferPool::global().set_budget( 2 * page );
+      ByteStreamTestHarness test { "budget limits capacity", 4 * page, ByteStream::Storage::Paged };
+
+      test.execute( AvailableCapacity { 2 * page } );
+      test.execute( Push { "cat" } );
+      test.execute( AvailableCapacity { 2 * page - 3 } );
+      test.execute( Push { one_page + one_page } );
+      test.execute( BytesPushed { 2 * page } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Pop { page } );
+      test.execute( AvailableCapacity { page } );
+      test.execute( Pop { page } );
+      test.execute( AvailableCapacity { 2 * page } );
+      test.execute( PoolInUse { 0 } );
+
+      BufferPool::global().set_budget( BufferPool::default_budget );
+    }
+
+    {
+      ByteStreamTestHarness test { "other streams share the budget", 4 * page, ByteStream::Storage::Paged };
+      BufferPool::global().set_budget( 3 * page );
+
+      ByteStream other { 4 * page, ByteStream::Storage::Paged };
+      other.writer().push( one_page + "x" );
+      test.execute( AvailableCapacity { page } );
+      test.execute( Push { one_page + "y" } );
+      test.execute( BytesPushed { page } );
+
+      string drained;
+      read( other.reader(), 2 * page, drained );
+      test.execute( AvailableCapacity { 2 * page } );
+
+      BufferPool::global().set_budget( BufferPool::default_budget );
+    }
+
+    {
+      ByteStreamTestHarness test { "shared pages outlive the pop", 4 * page, ByteStream::Storage::Paged };
+
+      test.execute( Push { "hello" } );
+      optional<Buffer> slice = test.peek_buffer();
+      test.execute( Pop { 5 } );
+      test.execute( PoolInUse { page } );
+      test.execute( Push { "world" } );
+      test.execute( PoolInUse { 2 * page } );
+      if ( not slice or string_view { *slice } != "hello" ) {
+        throw runtime_error( "peek_buffer() slice did not keep its bytes" );
+      }
+      slice.reset();
+      test.execute( PoolInUse { page } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
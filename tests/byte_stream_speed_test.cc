@@ -11,11 +11,27 @@
 using namespace std;
 using namespace std::chrono;
 
+string storage_name( ByteStream::Storage storage )
+{
+  switch ( storage ) {
+    case ByteStream::Storage::Chunked:
+      return "Chunked ";
+    case ByteStream::Storage::Mirrored:
+      return "Mirrored ";
+    case ByteStream::Storage::Paged:
+      return "Paged ";
+    case ByteStream::Storage::Ring:
+      break;
+  }
+  return "";
+}
+
 void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t write_size,  // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t read_size )  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t read_size,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const ByteStream::Storage storage = ByteStream::Storage::Ring )
 {
   // Generate the data to be written
   const string data = [&random_seed, &input_len] {
@@ -34,7 +50,7 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
     split_data.emplace( data.substr( i, write_size ) );
   }
 
-  ByteStream bs { capacity };
+  ByteStream bs { capacity, storage };
   string output_data;
   output_data.reserve( data.size() );
 
@@ -75,8 +91,9 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "ByteStream with capacity=" << capacity << ", write_size=" << write_size << ", read_size=" << read_size
-       << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+  cout << storage_name( storage ) << "ByteStream with capacity=" << capacity << ", write_size=" << write_size
+       << ", read_size=" << read_size << " reached " << fixed << setprecision( 2 ) << gigabits_per_second
+       << " Gbit/s.\n";
 
   debug_output << "             ByteStream throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
                << " Gbit/s\n";
@@ -89,6 +106,19 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
 void program_body()
 {
   speed_test( 1e7, 32768, 789, 1500, 128 );
+  speed_test( 1e7, 32768, 789, 1500, 128, ByteStream::Storage::Paged );
+
+  // a full 64 KB window drained by small reads: every pop leaves most of the window buffered
+  speed_test( 1e7, 65536, 789, 1500, 16 );
+  speed_test( 1e7, 65536, 789, 16384, 64 );
+
+  // large application writes: the ring copies each one in, the chunked storage moves it
+  speed_test( 1e7, 1 << 24, 789, 1 << 20, 1500 );
+  speed_test( 1e7, 1 << 24, 789, 1 << 20, 1500, ByteStream::Storage::Chunked );
+
+  // reads as large as the window: the ring's peek stops at the wrap point, the mirrored ring's never does
+  speed_test( 1e7, 65536, 789, 24000, 65536 );
+  speed_test( 1e7, 65536, 789, 24000, 65536, ByteStream::Storage::Mirrored );
 }
 
 int main()
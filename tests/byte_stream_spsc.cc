@@ -0,0 +1,122 @@
+#include "eventloop.hh"
+#include "spsc_byte_stream.hh"
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// Block until `event` fires; a timeout means a wakeup was lost.
+static void wait_for( EventFD& event, const string& what )
+{
+  EventLoop loop;
+  loop.add_rule( what, event, Direction::In, [&] { event.clear(); } );
+  if ( loop.wait_next_event( 5000 ) != EventLoop::Result::Success ) {
+    throw runtime_error( "SPSCByteStream: timed out waiting for " + what );
+  }
+}
+
+void spsc_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t max_chunk )  // NOLINT(bugprone-easily-swappable-parameters)
+{
+  const string data = [&] {
+    default_random_engine rd { random_seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  SPSCByteStream stream { capacity };
+
+  exception_ptr producer_error;
+  thread producer { [&] {
+    try {
+      default_random_engine rd { random_seed + 1 };
+      uniform_int_distribution<size_t> chunk_dist { 1, max_chunk };
+      size_t offset = 0;
+      while ( offset < data.size() and not stream.has_error() ) {
+        offset += stream.push( string_view { data }.substr( offset, chunk_dist( rd ) ) );
+        if ( stream.available_capacity() == 0 ) {
+          wait_for( stream.writable_event(), "space" );
+        }
+      }
+      stream.close();
+    } catch ( const exception& e ) {
+      producer_error = current_exception();
+      stream.set_error();
+    }
+  } };
+
+  default_random_engine rd { random_seed + 2 };
+  uniform_int_distribution<size_t> chunk_dist { 1, max_chunk };
+  string output;
+  try {
+    while ( not stream.is_finished() and not stream.has_error() ) {
+      if ( stream.bytes_buffered() == 0 ) {
+        wait_for( stream.readable_event(), "data" );
+        continue;
+      }
+      const auto view = stream.peek().substr( 0, chunk_dist( rd ) );
+      if ( view.empty() ) {
+        throw runtime_error( "SPSCByteStream::peek() returned empty view" );
+      }
+      output += view;
+      stream.pop( view.size() );
+    }
+  } catch ( const exception& e ) {
+    stream.set_error();
+    producer.join();
+    throw;
+  }
+  producer.join();
+
+  if ( producer_error ) {
+    rethrow_exception( producer_error );
+  }
+  if ( output != data ) {
+    throw runtime_error( "SPSCByteStream: mismatch between data written and read" );
+  }
+  if ( stream.bytes_pushed() != data.size() or stream.bytes_popped() != data.size() ) {
+    throw runtime_error( "SPSCByteStream: wrong bytes_pushed or bytes_popped" );
+  }
+}
+
+// clear() on an eventfd that is already clear does nothing
+static void eventfd_test()
+{
+  EventFD event;
+  event.clear();
+  event.notify();
+  event.clear();
+  event.clear();
+
+  EventLoop loop;
+  loop.add_rule( "eventfd", event, Direction::In, [] {} );
+  if ( loop.wait_next_event( 0 ) != EventLoop::Result::Timeout ) {
+    throw runtime_error( "EventFD: readable after clear()" );
+  }
+}
+
+int main()
+{
+  try {
+    eventfd_test();
+    spsc_test( 1000, 3, 10110, 5 );
+    spsc_test( 100000, 17, 12345, 40 );
+    spsc_test( 1000000, 4096, 98765, 1500 );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -16,11 +16,14 @@ static_assert( sizeof( Writer ) == sizeof( ByteStream ),
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
-  ByteStreamTestHarness( std::string test_name, uint64_t capacity )
-    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
+  ByteStreamTestHarness( std::string test_name,
+                         uint64_t capacity,
+                         ByteStream::Storage storage = ByteStream::Storage::Ring )
+    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity, storage } )
   {}
 
   size_t peek_size() { return object().reader().peek().size(); }
+  std::optional<Buffer> peek_buffer() { return object().reader().peek_buffer(); }
 };
 
 /* actions */
@@ -34,6 +37,53 @@ struct Push : public Action<ByteStream>
   void execute( ByteStream& bs ) const override { bs.writer().push( data_ ); }
 };
 
+struct PushBuffer : public Action<ByteStream>
+{
+  std::string data_;
+
+  explicit PushBuffer( std::string data ) : data_( move( data ) ) {}
+  std::string description() const override
+  {
+    return "push Buffer slice \"" + Printer::prettify( data_ ) + "\" to the stream";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    const Buffer padded { "<" + data_ + ">" };
+    bs.writer().push( padded.substr( 1, data_.size() ) );
+  }
+};
+
+struct PushReserved : public Action<ByteStream>
+{
+  std::string data_;
+  uint64_t pop_ {};
+
+  explicit PushReserved( std::string data ) : data_( move( data ) ) {}
+
+  // pop `len` bytes after reserving, before filling and committing
+  PushReserved& popping( uint64_t len )
+  {
+    pop_ = len;
+    return *this;
+  }
+
+  std::string description() const override
+  {
+    return "reserve" + ( pop_ ? ", pop( " + std::to_string( pop_ ) + " )" : std::string {} )
+           + ", fill and commit \"" + Printer::prettify( data_ ) + "\"";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    const auto spans = bs.writer().reserve( data_.size() );
+    bs.reader().pop( pop_ );
+    uint64_t written = 0;
+    for ( const auto span : spans ) {
+      written += data_.copy( span.data(), span.size(), written );
+    }
+    bs.writer().commit( written );
+  }
+};
+
 struct Close : public Action<ByteStream>
 {
   std::string description() const override { return "close"; }
@@ -55,6 +105,21 @@ struct Pop : public Action<ByteStream>
   void execute( ByteStream& bs ) const override { bs.reader().pop( len_ ); }
 };
 
+struct RetainPopped : public Action<ByteStream>
+{
+  std::string description() const override { return "retain_popped( true )"; }
+  void execute( ByteStream& bs ) const override { bs.reader().retain_popped( true ); }
+};
+
+struct Release : public Action<ByteStream>
+{
+  size_t len_;
+
+  explicit Release( size_t len ) : len_( len ) {}
+  std::string description() const override { return "release( " + std::to_string( len_ ) + " )"; }
+  void execute( ByteStream& bs ) const override { bs.reader().release( len_ ); }
+};
+
 /* expectations */
 
 struct Peek : public Expectation<ByteStream>
@@ -70,6 +135,15 @@ struct Peek : public Expectation<ByteStream>
     const ByteStream orig = bs;
     std::string got;
 
+    for ( const auto view : bs.reader().peek_all() ) {
+      got += view;
+    }
+    if ( got != output_ ) {
+      throw ExpectationViolation { "Expected \"" + Printer::prettify( output_ ) + "\" from peek_all(), "
+                                   + " but found \"" + Printer::prettify( got ) + "\"" };
+    }
+    got.clear();
+
     while ( bs.reader().bytes_buffered() ) {
       auto peeked = bs.reader().peek();
       if ( peeked.empty() ) {
@@ -163,6 +237,13 @@ struct BytesPopped : public ExpectNumber<ByteStream, uint64_t>
   size_t value( ByteStream& bs ) const override { return bs.reader().bytes_popped(); }
 };
 
+struct BytesRetained : public ExpectNumber<ByteStream, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "bytes_retained"; }
+  size_t value( ByteStream& bs ) const override { return bs.reader().bytes_retained(); }
+};
+
 struct ReadAll : public Expectation<ByteStream>
 {
   std::string output_;
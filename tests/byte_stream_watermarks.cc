@@ -0,0 +1,119 @@
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+struct WriterReady : public ExpectBool<ByteStream>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "writer().is_ready"; }
+  bool value( ByteStream& bs ) const override { return bs.writer().is_ready(); }
+};
+
+struct ReaderReady : public ExpectBool<ByteStream>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "reader().is_ready"; }
+  bool value( ByteStream& bs ) const override { return bs.reader().is_ready(); }
+};
+
+struct SetWatermarks : public Action<ByteStream>
+{
+  uint64_t write_low_, write_high_, read_low_, read_high_;
+
+  SetWatermarks( uint64_t write_low, // NOLINT(bugprone-easily-swappable-parameters)
+                 uint64_t write_high,
+                 uint64_t read_low,
+                 uint64_t read_high )
+    : write_low_( write_low ), write_high_( write_high ), read_low_( read_low ), read_high_( read_high )
+  {}
+  std::string description() const override { return "set watermarks"; }
+  void execute( ByteStream& bs ) const override
+  {
+    bs.writer().set_watermarks( write_low_, write_high_ );
+    bs.reader().set_watermarks( read_low_, read_high_ );
+  }
+};
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "defaults", 4 };
+
+      test.execute( WriterReady { true } );
+      test.execute( ReaderReady { false } );
+      test.execute( Push { "cat" } );
+      test.execute( WriterReady { true } );
+      test.execute( ReaderReady { true } );
+      test.execute( Push { "s" } );
+      test.execute( WriterReady { false } );
+      test.execute( Pop { 1 } );
+      test.execute( WriterReady { true } );
+      test.execute( Pop { 3 } );
+      test.execute( ReaderReady { false } );
+      test.execute( Close {} );
+      test.execute( ReaderReady { true } );
+      test.execute( WriterReady { false } );
+    }
+
+    {
+      ByteStreamTestHarness test { "hysteresis", 10 };
+      test.execute( SetWatermarks { 2, 6, 1, 4 } );
+      test.execute( WriterReady { true } );
+
+      // the reader waits for 4 bytes, then stays ready until it is drained
+      test.execute( Push { "abc" } );
+      test.execute( ReaderReady { false } );
+      test.execute( Push { "defgh" } );
+      test.execute( ReaderReady { true } );
+      test.execute( Pop { 7 } );
+      test.execute( ReaderReady { true } );
+      test.execute( Pop { 1 } );
+      test.execute( ReaderReady { false } );
+
+      // the writer stops being ready below 2 bytes of room, and is ready again only at 6
+      test.execute( Push { "ijklmnopq" } );
+      test.execute( WriterReady { false } );
+      test.execute( Pop { 3 } );
+      test.execute( WriterReady { false } );
+      test.execute( Pop { 2 } );
+      test.execute( WriterReady { true } );
+
+      // a high watermark above the capacity is clamped to it
+      test.execute( SetWatermarks { 1, 100, 1, 100 } );
+      test.execute( Pop { 4 } );
+      test.execute( WriterReady { true } );
+      test.execute( Push { "0123456789" } );
+      test.execute( ReaderReady { true } );
+    }
+
+    {
+      // the pool's budget leaves less room than the high watermark, which emptying the stream can't fix
+      BufferPool::global().set_budget( BufferPool::page_size );
+      ByteStreamTestHarness test { "with nothing buffered, any room will do", 4 * BufferPool::page_size,
+                                   ByteStream::Storage::Paged };
+      test.execute( SetWatermarks { 1, 2 * BufferPool::page_size, 1, 1 } );
+      test.execute( AvailableCapacity { BufferPool::page_size } );
+      test.execute( WriterReady { true } );
+
+      test.execute( Push { string( BufferPool::page_size, 'x' ) } );
+      test.execute( WriterReady { false } );
+      test.execute( Pop { 1 } );
+      test.execute( WriterReady { false } );
+      test.execute( Pop { BufferPool::page_size - 1 } );
+      test.execute( WriterReady { true } );
+      BufferPool::global().set_budget( BufferPool::default_budget );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,10 +1,12 @@
 #pragma once
 
+#include "tcp_receiver_message.hh"
 #include "wrapping_integers.hh"
 
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 // https://stackoverflow.com/questions/33399594/making-a-user-defined-class-stdto-stringable
 
@@ -32,6 +34,21 @@ std::string to_string( const std::optional<T>& v )
   return "None";
 }
 
+inline std::string to_string( const SACKBlock& b )
+{
+  return "[" + to_string( b.left_edge ) + ", " + to_string( b.right_edge ) + ")";
+}
+
+template<typename T>
+std::string to_string( const std::vector<T>& v )
+{
+  std::string ret = "{";
+  for ( const auto& x : v ) {
+    ret += ( ret.size() > 1 ? ", " : " " ) + to_string( x );
+  }
+  return ret + " }";
+}
+
 template<typename T>
 std::string as_string( T&& t )
 {
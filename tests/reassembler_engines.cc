@@ -0,0 +1,89 @@
+#include "byte_stream.hh"
+#include "reassembler.hh"
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// Feed the same random, overlapping, out-of-order substrings to a Reassembler of each engine,
+// and check that they write and hold exactly the same bytes (and report the same intervals) at every step.
+static void compare_engines( const size_t stream_len, // NOLINT(bugprone-easily-swappable-parameters)
+                             const size_t capacity,   // NOLINT(bugprone-easily-swappable-parameters)
+                             const size_t max_segment,
+                             const unsigned random_seed )
+{
+  default_random_engine rd { random_seed };
+  string data;
+  for ( size_t i = 0; i < stream_len; ++i ) {
+    data += static_cast<char>( 'a' + rd() % 26 );
+  }
+
+  ByteStream map_stream { capacity };
+  ByteStream bitmap_stream { capacity };
+  Reassembler map_reassembler { Reassembler::Engine::Map };
+  Reassembler bitmap_reassembler { Reassembler::Engine::Bitmap };
+  uint64_t bytes_read = 0;
+
+  const auto fail = [&]( const string& what ) {
+    throw runtime_error( "engines disagree (" + what + ") with capacity=" + to_string( capacity )
+                         + ", seed=" + to_string( random_seed ) );
+  };
+
+  for ( size_t step = 0; step < 100 * stream_len and not map_stream.reader().is_finished(); ++step ) {
+    // aim at and around the window, so that some substrings stick out of it on either side
+    const size_t window_start = map_stream.writer().bytes_pushed();
+    const size_t offset = rd() % ( capacity + 10 );
+    const size_t first_index = min( window_start - min<size_t>( 5, window_start ) + offset, stream_len );
+    const size_t len = min( rd() % ( max_segment + 1 ), stream_len - first_index );
+    const bool last = first_index + len == stream_len;
+
+    map_reassembler.insert( first_index, data.substr( first_index, len ), last, map_stream.writer() );
+    bitmap_reassembler.insert( first_index, data.substr( first_index, len ), last, bitmap_stream.writer() );
+
+    if ( map_reassembler.bytes_pending() != bitmap_reassembler.bytes_pending() ) {
+      fail( "bytes_pending" );
+    }
+    if ( map_reassembler.held_intervals() != bitmap_reassembler.held_intervals() ) {
+      fail( "held_intervals" );
+    }
+
+    const uint64_t to_read = rd() % ( capacity + 1 );
+    string map_chunk;
+    string bitmap_chunk;
+    read( map_stream.reader(), to_read, map_chunk );
+    read( bitmap_stream.reader(), to_read, bitmap_chunk );
+    if ( map_chunk != bitmap_chunk or map_chunk != string_view { data }.substr( bytes_read, map_chunk.size() ) ) {
+      fail( "output" );
+    }
+    bytes_read += map_chunk.size();
+    if ( map_stream.writer().is_closed() != bitmap_stream.writer().is_closed() ) {
+      fail( "is_closed" );
+    }
+  }
+
+  if ( not map_stream.reader().is_finished() or not bitmap_stream.reader().is_finished() ) {
+    fail( "stream never finished" );
+  }
+}
+
+int main()
+{
+  try {
+    for ( unsigned seed = 0; seed < 20; ++seed ) {
+      compare_engines( 500, 1, 3, seed );
+      compare_engines( 1000, 63, 20, seed );
+      compare_engines( 2000, 64, 100, seed );
+      compare_engines( 5000, 200, 70, seed );
+      compare_engines( 5000, 1500, 1000, seed );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+#include "reassembler_test_harness.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "fragment limit evicts the furthest fragment", 65000 };
+
+      test.execute( SetLimits { 2, UINT64_MAX } );
+      test.execute( Insert { "b", 1 } );
+      test.execute( Insert { "d", 3 } );
+      test.execute( BytesPending( 2 ) );
+      test.execute( FragmentsEvicted( 0 ) );
+
+      test.execute( Insert { "ff", 5 } );
+      test.execute( BytesPending( 2 ) );
+      test.execute( FragmentsEvicted( 1 ) );
+      test.execute( BytesEvicted( 2 ) );
+
+      // joining "b" and "d" into one run, "c" makes room rather than taking it
+      test.execute( Insert { "c", 2 } );
+      test.execute( BytesPending( 3 ) );
+      test.execute( FragmentsEvicted( 1 ) );
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( BytesPushed( 4 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcd" ) );
+
+      test.execute( Insert { "efg", 4 }.is_last() );
+      test.execute( ReadAll( "efg" ) );
+      test.execute( IsFinished( true ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "fragment that closes a hole is not a new fragment", 65000 };
+
+      test.execute( SetLimits { 2, UINT64_MAX } );
+      test.execute( Insert { "b", 1 } );
+      test.execute( Insert { "d", 3 } );
+      test.execute( Insert { "bcd", 1 } );
+      test.execute( BytesPending( 3 ) );
+      test.execute( FragmentsEvicted( 0 ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "touching fragments count once against the fragment limit", 65000 };
+
+      test.execute( SetLimits { 1, UINT64_MAX } );
+      test.execute( Insert { "b", 1 } );
+      test.execute( Insert { "c", 2 } );
+      test.execute( Insert { "d", 3 } );
+      test.execute( BytesPending( 3 ) );
+      test.execute( FragmentsEvicted( 0 ) );
+
+      test.execute( Insert { "f", 5 } );
+      test.execute( BytesPending( 3 ) );
+      test.execute( FragmentsEvicted( 1 ) );
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( ReadAll( "abcd" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "touching slices of one Buffer join into one fragment", 65000 };
+
+      // room for the overhead of one fragment only
+      const Buffer stream { "abcdef" };
+      test.execute( SetLimits { UINT64_MAX, Reassembler::fragment_overhead } );
+      test.execute( InsertSlice { stream, 3, 2 } );
+      test.execute( InsertSlice { stream, 1, 2 } );
+      test.execute( InsertSlice { stream, 5, 1 } );
+      test.execute( BytesPending( 5 ) );
+      test.execute( FragmentsEvicted( 0 ) );
+
+      // touching, but from another Buffer: small enough to be copied onto the end of it, spare room and all
+      test.execute( SetLimits { UINT64_MAX, 2 * Reassembler::fragment_overhead } );
+      test.execute( Insert { "g", 6 } );
+      test.execute( BytesPending( 6 ) );
+      test.execute( FragmentsEvicted( 0 ) );
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( ReadAll( "abcdefg" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "in-order bytes are never evicted", 65000 };
+
+      test.execute( SetLimits { 0, 0 } );
+      test.execute( Insert { "b", 1 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( FragmentsEvicted( 1 ) );
+
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPushed( 2 ) );
+      test.execute( ReadAll( "ab" ) );
+      test.execute( FragmentsEvicted( 1 ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "overhead limit counts the bytes a slice keeps alive", 100 };
+
+      // only 50 bytes of the 1000-byte insert fit in the window, but holding them keeps all 1000 alive
+      const uint64_t overhead = Reassembler::fragment_overhead;
+      test.execute( SetLimits { UINT64_MAX, 2 * overhead + 500 } );
+      test.execute( Insert { "b", 1 } );
+      test.execute( Insert { string( 1000, 'c' ), 50 } );
+      test.execute( BytesPending( 1 ) );
+      test.execute( FragmentsEvicted( 1 ) );
+      test.execute( BytesEvicted( 50 ) );
+
+      test.execute( Insert { string( 10, 'c' ), 50 } );
+      test.execute( BytesPending( 11 ) );
+      test.execute( FragmentsEvicted( 1 ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "lowering the limits evicts at once", 65000 };
+
+      for ( uint64_t i = 1; i < 20; i += 2 ) {
+        test.execute( Insert { "x", i } );
+      }
+      test.execute( BytesPending( 10 ) );
+
+      test.execute( SetLimits { 3, UINT64_MAX } );
+      test.execute( BytesPending( 3 ) );
+      test.execute( FragmentsEvicted( 7 ) );
+      test.execute( BytesEvicted( 7 ) );
+
+      test.execute( Insert { string( 20, 'y' ), 0 } );
+      test.execute( BytesPushed( 20 ) );
+      test.execute( ReadAll( string( 20, 'y' ) ) );
+    }
+
+    // a capacity just large enough to raise the default fragment limit (twice over)
+    const uint64_t large_capacity = 2 * Reassembler::default_max_fragments * Reassembler::fragment_overhead;
+
+    {
+      ReassemblerTestHarness test { "one-byte fragments stay within the default limits", large_capacity };
+
+      // the limits follow the capacity: a fragment (and its overhead) per fragment_overhead bytes
+      const uint64_t held = large_capacity / Reassembler::fragment_overhead;
+      for ( uint64_t i = 0; i < held + 1000; i++ ) {
+        test.execute( Insert { "x", 2 * i + 1 } );
+      }
+      test.execute( BytesPending( held ) );
+      test.execute( FragmentsEvicted( 1000 ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "in-order data behind a single hole is never evicted", large_capacity };
+
+      // small segments, filling the whole window behind the first one
+      const uint64_t len = Reassembler::fragment_overhead;
+      for ( uint64_t i = len; i + len <= large_capacity; i += len ) {
+        test.execute( Insert { string( len, 'y' ), i } );
+      }
+      test.execute( FragmentsEvicted( 0 ) );
+
+      test.execute( Insert { string( len, 'x' ), 0 } );
+      test.execute( BytesPending( 0 ) );
+      test.execute( BytesPushed( large_capacity / len * len ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "the default limits hold for a small stream", 65000 };
+
+      for ( uint64_t i = 1; i < 65000; i += 2 ) {
+        test.execute( Insert { "x", i } );
+      }
+      test.execute( BytesPending( Reassembler::default_max_fragments ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
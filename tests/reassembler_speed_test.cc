@@ -3,51 +3,69 @@
 #include <algorithm>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <queue>
 #include <random>
+#include <sstream>
+#include <stdexcept>
 #include <tuple>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
 
-void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
-{
-  // Generate the data to be written
-  const string data = [&] {
-    default_random_engine rd { random_seed };
-    uniform_int_distribution<char> ud;
-    string ret;
-    for ( size_t i = 0; i < num_chunks * capacity; ++i ) {
-      ret += ud( rd );
-    }
-    return ret;
-  }();
+using Segments = queue<tuple<uint64_t, string, bool>>;
 
-  // Split the data into segments before writing
-  queue<tuple<uint64_t, string, bool>> split_data;
-  for ( size_t i = 0; i < data.size(); i += capacity ) {
-    split_data.emplace( i + 2, data.substr( i + 2, capacity * 2 ), i + 2 + capacity * 2 >= data.size() );
-    split_data.emplace( i, data.substr( i, capacity * 2 ), i + capacity * 2 >= data.size() );
-    split_data.emplace( i + 1, data.substr( i + 1, capacity * 2 ), i + 1 + capacity * 2 >= data.size() );
+string random_string( const size_t len, const size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  uniform_int_distribution<char> ud;
+  string ret;
+  for ( size_t i = 0; i < len; ++i ) {
+    ret += ud( rd );
   }
+  return ret;
+}
 
+// nanoseconds at or below which `fraction` of the latencies lie
+uint64_t percentile( const vector<uint64_t>& sorted_latencies, const double fraction )
+{
+  const auto rank = static_cast<size_t>( fraction * static_cast<double>( sorted_latencies.size() - 1 ) );
+  return sorted_latencies.at( rank );
+}
+
+void speed_test( const string& name, // NOLINT(bugprone-easily-swappable-parameters)
+                 const string& data,
+                 Segments split_data,
+                 const size_t capacity,
+                 Reassembler::Engine engine,
+                 const double min_gigabits_per_second = 0.1 )
+{
   ByteStream stream { capacity };
-  Reassembler reassembler;
+  Reassembler reassembler { engine };
+  // nothing is sent again here, so the Reassembler has to hold every fragment
+  reassembler.set_limits( UINT64_MAX, UINT64_MAX );
 
   string output_data;
   output_data.reserve( data.size() );
 
+  vector<uint64_t> latencies;
+  latencies.reserve( split_data.size() );
+  uint64_t peak_bytes_pending = 0;
+
   const auto start_time = steady_clock::now();
   while ( not split_data.empty() ) {
     auto& next = split_data.front();
+    const auto insert_start = steady_clock::now();
     reassembler.insert( get<uint64_t>( next ), move( get<string>( next ) ), get<bool>( next ), stream.writer() );
+    latencies.push_back( duration_cast<nanoseconds>( steady_clock::now() - insert_start ).count() );
     split_data.pop();
 
+    peak_bytes_pending = max( peak_bytes_pending, reassembler.bytes_pending() );
+
     while ( stream.reader().bytes_buffered() ) {
       output_data += stream.reader().peek();
       stream.reader().pop( output_data.size() - stream.reader().bytes_popped() );
@@ -64,28 +82,213 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
     throw runtime_error( "Mismatch between data written and read" );
   }
 
+  if ( peak_bytes_pending > capacity ) {
+    throw runtime_error( "Reassembler held more bytes than the stream's capacity" );
+  }
+
   auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
-  auto bytes_per_second = static_cast<double>( num_chunks * capacity ) / test_duration.count();
+  auto bytes_per_second = static_cast<double>( data.size() ) / test_duration.count();
   auto bits_per_second = 8 * bytes_per_second;
   auto gigabits_per_second = bits_per_second / 1e9;
 
+  sort( latencies.begin(), latencies.end() );
+
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
-       << gigabits_per_second << " Gbit/s.\n";
+  const string engine_name = engine == Reassembler::Engine::Bitmap ? "Bitmap " : "";
+
+  cout << engine_name << "Reassembler " << name << " to ByteStream with capacity=" << capacity << " reached "
+       << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s";
+  cout << " (insert latency p50/p99/p99.9 = " << percentile( latencies, 0.5 ) << "/"
+       << percentile( latencies, 0.99 ) << "/" << percentile( latencies, 0.999 )
+       << " ns, peak bytes_pending = " << peak_bytes_pending << ").\n";
+
+  debug_output << "             " << engine_name << "Reassembler throughput (" << name << "): " << fixed
+               << setprecision( 2 ) << gigabits_per_second << " Gbit/s\n";
+
+  if ( gigabits_per_second < min_gigabits_per_second ) {
+    ostringstream ss;
+    ss << "Reassembler did not meet minimum speed of " << min_gigabits_per_second << " Gbit/s.";
+    throw runtime_error( ss.str() );
+  }
+}
+
+// overlapping segments, each delivered slightly out of order
+void overlap_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-parameters)
+                   const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                   const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                   Reassembler::Engine engine = Reassembler::Engine::Map )
+{
+  const string data = random_string( num_chunks * capacity, random_seed );
+
+  // Split the data into segments before writing
+  Segments split_data;
+  for ( size_t i = 0; i < data.size(); i += capacity ) {
+    split_data.emplace( i + 2, data.substr( i + 2, capacity * 2 ), i + 2 + capacity * 2 >= data.size() );
+    split_data.emplace( i, data.substr( i, capacity * 2 ), i + capacity * 2 >= data.size() );
+    split_data.emplace( i + 1, data.substr( i + 1, capacity * 2 ), i + 1 + capacity * 2 >= data.size() );
+  }
+
+  speed_test( "(overlapping)", data, move( split_data ), capacity, engine );
+}
+
+// a window full of holes: every other segment arrives first, then the rest fill in from the far end
+void holes_test( const size_t num_windows,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t segment_size, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed,  // NOLINT(bugprone-easily-swappable-parameters)
+                 Reassembler::Engine engine = Reassembler::Engine::Map )
+{
+  const string data = random_string( num_windows * capacity, random_seed );
+
+  Segments split_data;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    for ( size_t i = window + segment_size; i < window + capacity; i += 2 * segment_size ) {
+      split_data.emplace( i, data.substr( i, segment_size ), i + segment_size >= data.size() );
+    }
+    for ( size_t i = window + capacity - 2 * segment_size;; i -= 2 * segment_size ) {
+      split_data.emplace( i, data.substr( i, segment_size ), i + segment_size >= data.size() );
+      if ( i == window ) {
+        break;
+      }
+    }
+  }
+
+  speed_test( "(many holes)", data, move( split_data ), capacity, engine );
+}
+
+// each window arrives back to front, so nothing can be written until its first segment comes last
+void reverse_test( const size_t num_windows,  // NOLINT(bugprone-easily-swappable-parameters)
+                   const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                   const size_t segment_size, // NOLINT(bugprone-easily-swappable-parameters)
+                   const size_t random_seed,  // NOLINT(bugprone-easily-swappable-parameters)
+                   Reassembler::Engine engine = Reassembler::Engine::Map )
+{
+  const string data = random_string( num_windows * capacity, random_seed );
+
+  Segments split_data;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    for ( size_t i = window + capacity - segment_size;; i -= segment_size ) {
+      split_data.emplace( i, data.substr( i, segment_size ), i + segment_size >= data.size() );
+      if ( i == window ) {
+        break;
+      }
+    }
+  }
+
+  speed_test( "(reverse order)", data, move( split_data ), capacity, engine );
+}
+
+// every byte is its own segment, the odd ones first: the most fragments a window can hold
+void tiny_test( const size_t num_windows, // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                Reassembler::Engine engine = Reassembler::Engine::Map )
+{
+  const string data = random_string( num_windows * capacity, random_seed );
+
+  Segments split_data;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    for ( size_t parity : { 1, 0 } ) {
+      for ( size_t i = window + parity; i < window + capacity; i += 2 ) {
+        split_data.emplace( i, data.substr( i, 1 ), i + 1 == data.size() );
+      }
+    }
+  }
+
+  // a byte per insert can't reach the usual bit rate
+  speed_test( "(1-byte fragments)", data, move( split_data ), capacity, engine, 0.01 );
+}
+
+// each byte arrives in `coverage` segments, starting every segment_size / coverage bytes in shuffled runs
+void heavy_overlap_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t segment_size, // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t coverage,     // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t random_seed,  // NOLINT(bugprone-easily-swappable-parameters)
+                         Reassembler::Engine engine = Reassembler::Engine::Map )
+{
+  const string data = random_string( num_chunks * segment_size, random_seed );
+  const size_t stride = segment_size / coverage;
+  default_random_engine rd { random_seed };
+
+  vector<size_t> starts;
+  for ( size_t i = 0; i < data.size(); i += stride ) {
+    starts.push_back( i );
+  }
+  for ( size_t i = 0; i < starts.size(); i += 2 * coverage ) {
+    shuffle( starts.begin() + i, starts.begin() + min( i + 2 * coverage, starts.size() ), rd );
+  }
+
+  Segments split_data;
+  for ( const size_t i : starts ) {
+    split_data.emplace( i, data.substr( i, segment_size ), i + segment_size >= data.size() );
+  }
+
+  speed_test( "(heavy overlap)", data, move( split_data ), capacity, engine );
+}
+
+// the holes pattern, with every segment delivered `copies` times in a row
+void duplicates_test( const size_t num_windows,  // NOLINT(bugprone-easily-swappable-parameters)
+                      const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                      const size_t segment_size, // NOLINT(bugprone-easily-swappable-parameters)
+                      const size_t copies,       // NOLINT(bugprone-easily-swappable-parameters)
+                      const size_t random_seed,  // NOLINT(bugprone-easily-swappable-parameters)
+                      Reassembler::Engine engine = Reassembler::Engine::Map )
+{
+  const string data = random_string( num_windows * capacity, random_seed );
+
+  Segments split_data;
+  const auto emplace_copies = [&]( size_t i ) {
+    for ( size_t copy = 0; copy < copies; ++copy ) {
+      split_data.emplace( i, data.substr( i, segment_size ), i + segment_size >= data.size() );
+    }
+  };
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    for ( size_t i = window + segment_size; i < window + capacity; i += 2 * segment_size ) {
+      emplace_copies( i );
+    }
+    for ( size_t i = window; i < window + capacity; i += 2 * segment_size ) {
+      emplace_copies( i );
+    }
+  }
+
+  speed_test( "(duplicate storm)", data, move( split_data ), capacity, engine );
+}
 
-  debug_output << "             Reassembler throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
-               << " Gbit/s\n";
+// a segment as large as the window arrives ahead of each gap, so it is cut at the window's far end
+void window_edge_test( const size_t num_gaps,     // NOLINT(bugprone-easily-swappable-parameters)
+                       const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                       const size_t segment_size, // NOLINT(bugprone-easily-swappable-parameters)
+                       const size_t random_seed,  // NOLINT(bugprone-easily-swappable-parameters)
+                       Reassembler::Engine engine = Reassembler::Engine::Map )
+{
+  const string data = random_string( num_gaps * segment_size, random_seed );
 
-  if ( gigabits_per_second < 0.1 ) {
-    throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s." );
+  Segments split_data;
+  for ( size_t i = 0; i < data.size(); i += segment_size ) {
+    const size_t ahead = i + segment_size;
+    if ( ahead < data.size() ) {
+      split_data.emplace( ahead, data.substr( ahead, capacity ), ahead + capacity >= data.size() );
+    }
+    split_data.emplace( i, data.substr( i, segment_size ), i + segment_size >= data.size() );
   }
+
+  speed_test( "(window-edge truncation)", data, move( split_data ), capacity, engine );
 }
 
 void program_body()
 {
-  speed_test( 10000, 1500, 1370 );
+  for ( const auto engine : { Reassembler::Engine::Map, Reassembler::Engine::Bitmap } ) {
+    overlap_test( 10000, 1500, 1370, engine );
+    holes_test( 16, 1 << 20, 64, 1370, engine );
+    reverse_test( 16, 1 << 20, 1024, 1370, engine );
+    tiny_test( 64, 1 << 14, 1370, engine );
+    heavy_overlap_test( 4096, 1 << 16, 1024, 16, 1370, engine );
+    duplicates_test( 16, 1 << 18, 256, 8, 1370, engine );
+    window_edge_test( 16384, 1 << 16, 1024, 1370, engine );
+  }
 }
 
 int main()
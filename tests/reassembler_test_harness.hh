@@ -50,6 +50,41 @@ struct BytesPending : public ExpectNumber<StreamAndReassembler, uint64_t>
   uint64_t value( StreamAndReassembler& sr ) const override { return sr.second.bytes_pending(); }
 };
 
+struct FragmentsEvicted : public ExpectNumber<StreamAndReassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "fragments_evicted"; }
+  uint64_t value( StreamAndReassembler& sr ) const override { return sr.second.fragments_evicted(); }
+};
+
+struct BytesEvicted : public ExpectNumber<StreamAndReassembler, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "bytes_evicted"; }
+  uint64_t value( StreamAndReassembler& sr ) const override { return sr.second.bytes_evicted(); }
+};
+
+struct SetLimits : public Action<StreamAndReassembler>
+{
+  uint64_t max_fragments_;
+  uint64_t max_overhead_bytes_;
+
+  SetLimits( uint64_t max_fragments, uint64_t max_overhead_bytes )
+    : max_fragments_( max_fragments ), max_overhead_bytes_( max_overhead_bytes )
+  {}
+
+  std::string description() const override
+  {
+    return "set limits: " + std::to_string( max_fragments_ ) + " fragments, "
+           + std::to_string( max_overhead_bytes_ ) + " bytes of overhead";
+  }
+
+  void execute( StreamAndReassembler& sr ) const override
+  {
+    sr.second.set_limits( max_fragments_, max_overhead_bytes_ );
+  }
+};
+
 struct Insert : public Action<StreamAndReassembler>
 {
   std::string data_;
@@ -79,3 +114,27 @@ struct Insert : public Action<StreamAndReassembler>
     sr.second.insert( first_index_, data_, is_last_substring_, sr.first.writer() );
   }
 };
+
+// Insert the bytes [first_index, first_index + len) of a Buffer holding the stream from index 0, as a slice
+// sharing its storage
+struct InsertSlice : public Action<StreamAndReassembler>
+{
+  Buffer stream_;
+  uint64_t first_index_;
+  uint64_t len_;
+
+  InsertSlice( Buffer stream, uint64_t first_index, uint64_t len )
+    : stream_( std::move( stream ) ), first_index_( first_index ), len_( len )
+  {}
+
+  std::string description() const override
+  {
+    return "insert slice \"" + Printer::prettify( std::string_view { stream_ }.substr( first_index_, len_ ) )
+           + "\" @ index " + std::to_string( first_index_ );
+  }
+
+  void execute( StreamAndReassembler& sr ) const override
+  {
+    sr.second.insert( first_index_, stream_.substr( first_index_, len_ ), false, sr.first.writer() );
+  }
+};
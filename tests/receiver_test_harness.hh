@@ -8,6 +8,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 using ReceiverSet = std::pair<StreamAndReassembler, TCPReceiver>;
 
@@ -66,6 +67,26 @@ struct ExpectAckno : public ExpectNumber<ReceiverSet, std::optional<Wrap32>>
   }
 };
 
+struct ExpectSACKBlocks : public ExpectNumber<ReceiverSet, std::vector<SACKBlock>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "sack_blocks"; }
+  std::vector<SACKBlock> value( ReceiverSet& rs ) const override
+  {
+    return rs.second.send( rs.first.first.writer(), rs.first.second ).sack_blocks;
+  }
+};
+
+struct ExpectTSecr : public ExpectNumber<ReceiverSet, std::optional<uint32_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "tsecr"; }
+  std::optional<uint32_t> value( ReceiverSet& rs ) const override
+  {
+    return rs.second.send( rs.first.first.writer() ).tsecr;
+  }
+};
+
 struct ExpectAcknoBetween : public Expectation<ReceiverSet>
 {
   Wrap32 isn_;
@@ -104,6 +125,15 @@ struct HasAckno : public ExpectBool<ReceiverSet>
   }
 };
 
+struct SetWindowShift : public Action<ReceiverSet>
+{
+  uint8_t shift_;
+
+  explicit SetWindowShift( uint8_t shift ) : shift_( shift ) {}
+  std::string description() const override { return "set window shift to " + std::to_string( shift_ ); }
+  void execute( ReceiverSet& rs ) const override { rs.second.set_window_shift( shift_ ); }
+};
+
 struct SegmentArrives : public Action<ReceiverSet>
 {
   TCPSenderMessage msg_ {};
@@ -135,6 +165,12 @@ struct SegmentArrives : public Action<ReceiverSet>
     return *this;
   }
 
+  SegmentArrives& with_tsval( uint32_t tsval )
+  {
+    msg_.tsval = tsval;
+    return *this;
+  }
+
   SegmentArrives& without_ackno()
   {
     ackno_expected_ = HasAckno { false };
@@ -161,6 +197,9 @@ struct SegmentArrives : public Action<ReceiverSet>
     if ( msg_.FIN ) {
       ss << " +FIN";
     }
+    if ( msg_.tsval.has_value() ) {
+      ss << " tsval=" << msg_.tsval.value();
+    }
     ss << ")";
 
     if ( ackno_expected_.value_ ) {
@@ -0,0 +1,99 @@
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      const uint32_t isn = 3456;
+      TCPReceiverTestHarness test { "no SACK blocks before the SYN or without holes", 4000 };
+      test.execute( ExpectSACKBlocks { vector<SACKBlock> {} } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).without_ackno() );
+      test.execute( ExpectSACKBlocks { vector<SACKBlock> {} } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectSACKBlocks { vector<SACKBlock> {} } );
+    }
+
+    {
+      const uint32_t isn = 3456;
+      TCPReceiverTestHarness test { "SACK blocks follow the held data", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSACKBlocks { vector<SACKBlock> { { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+
+      test.execute( SegmentArrives {}.with_seqno( isn + 13 ).with_data( "mn" ) );
+      test.execute( ExpectSACKBlocks { vector<SACKBlock> {
+        { Wrap32 { isn + 13 }, Wrap32 { isn + 15 } }, { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+
+      // touching segments make one block
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) );
+      test.execute( ExpectSACKBlocks { vector<SACKBlock> { { Wrap32 { isn + 5 }, Wrap32 { isn + 15 } } } } );
+
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 15 } } );
+      test.execute( ExpectSACKBlocks { vector<SACKBlock> {} } );
+      test.execute( ReadAll { "abcdefghijklmn" } );
+    }
+
+    {
+      const uint32_t isn = UINT32_MAX - 4;
+      TCPReceiverTestHarness test { "at most four SACK blocks, newest first, across the wrap", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint32_t i = 0; i < 6; i++ ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 3 + 4 * i ).with_data( "xx" ) );
+      }
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSACKBlocks { vector<SACKBlock> { { Wrap32 { isn + 23 }, Wrap32 { isn + 25 } },
+                                                           { Wrap32 { isn + 19 }, Wrap32 { isn + 21 } },
+                                                           { Wrap32 { isn + 15 }, Wrap32 { isn + 17 } },
+                                                           { Wrap32 { isn + 11 }, Wrap32 { isn + 13 } } } } );
+    }
+
+    {
+      const uint32_t isn = 91;
+      TCPReceiverTestHarness test { "the block with the latest segment goes first, the rest lowest first", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint32_t i = 0; i < 6; i++ ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 3 + 4 * i ).with_data( "xx" ) );
+      }
+
+      // an early block grows: it goes first, then the latest ones still fill the rest
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "yy" ) );
+      test.execute( ExpectSACKBlocks { vector<SACKBlock> { { Wrap32 { isn + 3 }, Wrap32 { isn + 9 } },
+                                                           { Wrap32 { isn + 23 }, Wrap32 { isn + 25 } },
+                                                           { Wrap32 { isn + 19 }, Wrap32 { isn + 21 } },
+                                                           { Wrap32 { isn + 15 }, Wrap32 { isn + 17 } } } } );
+
+      // a duplicate of held data counts as the latest segment too
+      test.execute( SegmentArrives {}.with_seqno( isn + 11 ).with_data( "xx" ) );
+      test.execute( ExpectSACKBlocks { vector<SACKBlock> { { Wrap32 { isn + 11 }, Wrap32 { isn + 13 } },
+                                                           { Wrap32 { isn + 3 }, Wrap32 { isn + 9 } },
+                                                           { Wrap32 { isn + 23 }, Wrap32 { isn + 25 } },
+                                                           { Wrap32 { isn + 19 }, Wrap32 { isn + 21 } } } } );
+
+      // once the hole fills, blocks drained to the stream drop out and the others keep their order
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "ab" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+      test.execute( ExpectSACKBlocks { vector<SACKBlock> { { Wrap32 { isn + 11 }, Wrap32 { isn + 13 } },
+                                                           { Wrap32 { isn + 23 }, Wrap32 { isn + 25 } },
+                                                           { Wrap32 { isn + 19 }, Wrap32 { isn + 21 } },
+                                                           { Wrap32 { isn + 15 }, Wrap32 { isn + 17 } } } } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
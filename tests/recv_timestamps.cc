@@ -0,0 +1,73 @@
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      const uint32_t isn = 700;
+      TCPReceiverTestHarness test { "the in-sequence timestamp is echoed", 4000 };
+      test.execute( ExpectTSecr { nullopt } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_tsval( 10 ) );
+      test.execute( ExpectTSecr { 10 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_tsval( 20 ) );
+      test.execute( ExpectTSecr { 20 } );
+
+      // a segment beyond the ackno doesn't move the echo
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ).with_tsval( 30 ) );
+      test.execute( ExpectTSecr { 20 } );
+
+      // the one filling the hole does
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_tsval( 40 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 13 } } );
+      test.execute( ExpectTSecr { 40 } );
+    }
+
+    {
+      const uint32_t isn = 700;
+      TCPReceiverTestHarness test { "PAWS rejects old duplicates", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_tsval( 1000 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_tsval( 1010 ) );
+
+      // a segment from a previous trip around the sequence space, stamped earlier
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "old!" ).with_tsval( 990 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( ExpectTSecr { 1010 } );
+
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_tsval( 1010 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+      test.execute( ReadAll { "abcdefgh" } );
+    }
+
+    {
+      const uint32_t isn = 700;
+      TCPReceiverTestHarness test { "timestamps compare modulo 2^32", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_tsval( UINT32_MAX - 5 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_tsval( 3 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectTSecr { 3 } );
+    }
+
+    {
+      const uint32_t isn = 700;
+      TCPReceiverTestHarness test { "segments without timestamps are unaffected", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectTSecr { nullopt } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
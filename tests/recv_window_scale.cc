@@ -0,0 +1,50 @@
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      const uint32_t isn = 5000;
+      TCPReceiverTestHarness test { "without scaling, the window stops at 65535", 4'000'000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectWindow { UINT16_MAX } );
+    }
+
+    {
+      const uint32_t isn = 5000;
+      TCPReceiverTestHarness test { "a 4 MB buffer advertises a 4 MB window", 4'000'000 };
+      test.execute( SetWindowShift { 6 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectWindow { 4'000'000 >> 6 } );
+
+      // rounded down, so the window never promises more room than there is
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 100, 'x' ) ) );
+      test.execute( ExpectWindow { ( 4'000'000 - 100 ) >> 6 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 101 } } );
+    }
+
+    {
+      const uint32_t isn = 5000;
+      TCPReceiverTestHarness test { "data beyond 64 KB is accepted with a scaled window", 200'000 };
+      test.execute( SetWindowShift { 2 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 + 100'000 ).with_data( "far" ) );
+      test.execute( BytesPending { 3 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 100'000, 'x' ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 100'004 } } );
+      test.execute( ExpectWindow { ( 200'000 - 100'003 ) >> 2 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// SYN, then its ack, opening a large window: the ack grows cwnd by one byte in slow start
+static void connect( TCPSenderTestHarness& test, Wrap32 isn )
+{
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+  test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+  test.execute( ExpectCwnd { 10001 } );
+}
+
+// expect `count` full segments
+static void expect_full_segments( TCPSenderTestHarness& test, size_t count )
+{
+  for ( size_t i = 0; i < count; i++ ) {
+    test.execute( ExpectMessage {}.with_payload_size( TCPConfig::MAX_PAYLOAD_SIZE ) );
+  }
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "NewReno slow start", cfg, CongestionControl::Algorithm::NewReno };
+      test.execute( ExpectCwnd { 10000 } );
+      test.execute( ExpectSsthresh { UINT64_MAX } );
+      connect( test, isn );
+
+      test.execute( Push { string( 30000, 'x' ) } );
+      expect_full_segments( test, 10 );
+      test.execute( ExpectMessage {}.with_payload_size( 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 10001 } );
+
+      // each segment acknowledged lets two more go
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectCwnd { 11001 } );
+      expect_full_segments( test, 2 );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "NewReno halves on loss, and grows by a segment per window", cfg,
+                                  CongestionControl::Algorithm::NewReno };
+      connect( test, isn );
+      test.execute( Push { string( 10000, 'x' ) } );
+      expect_full_segments( test, 10 );
+
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ).with_sack( isn + 1001, isn + 4001 ) );
+      test.execute( ExpectSsthresh { 5000 } );
+      test.execute( ExpectCwnd { 5000 } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the ack that ends recovery doesn't grow the window
+      test.execute( AckReceived { isn + 10001 }.with_win( 60000 ) );
+      test.execute( ExpectCwnd { 5000 } );
+
+      test.execute( Push { string( 10000, 'y' ) } );
+      expect_full_segments( test, 5 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 13001 }.with_win( 60000 ) );
+      test.execute( ExpectCwnd { 5000 } );
+      test.execute( AckReceived { isn + 15001 }.with_win( 60000 ) );
+      test.execute( ExpectCwnd { 6000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "NewReno drops to one segment on timeout", cfg,
+                                  CongestionControl::Algorithm::NewReno };
+      connect( test, isn );
+      test.execute( Push { string( 8000, 'x' ) } );
+      expect_full_segments( test, 8 );
+
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectSsthresh { 4000 } );
+      test.execute( ExpectCwnd { 1000 } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "SACK recovery sends holes again only as the pipe has room", cfg,
+                                  CongestionControl::Algorithm::NewReno };
+      connect( test, isn );
+      test.execute( Push { string( 10000, 'x' ) } );
+      expect_full_segments( test, 10 );
+
+      // eight holes, but cwnd is down to five segments
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ).with_sack( isn + 8001, isn + 10001 ) );
+      test.execute( ExpectCwnd { 5000 } );
+      for ( uint32_t offset = 1; offset < 5000; offset += 1000 ) {
+        test.execute( ExpectMessage {}.with_seqno( isn + offset ).with_payload_size( 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+
+      // two retransmissions leave the network, so two more holes go
+      test.execute( AckReceived { isn + 2001 }.with_win( 60000 ).with_sack( isn + 8001, isn + 10001 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 5001 ).with_payload_size( 1000 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 6001 ).with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( AckReceived { isn + 7001 }.with_win( 60000 ).with_sack( isn + 8001, isn + 10001 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 7001 ).with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "CUBIC backs off by 30%, then grows with time", cfg,
+                                  CongestionControl::Algorithm::Cubic };
+      connect( test, isn );
+      test.execute( Push { string( 10000, 'x' ) } );
+      expect_full_segments( test, 10 );
+
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ).with_sack( isn + 1001, isn + 4001 ) );
+      test.execute( ExpectSsthresh { 7000 } );
+      test.execute( ExpectCwnd { 7000 } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_payload_size( 1000 ) );
+      test.execute( AckReceived { isn + 10001 }.with_win( 60000 ) );
+
+      // right after the loss, the Reno-friendly estimate leads
+      test.execute( Push { string( 1000, 'y' ) } );
+      expect_full_segments( test, 1 );
+      test.execute( AckReceived { isn + 11001 }.with_win( 60000 ) );
+      test.execute( ExpectCwnd { 7076 } );
+
+      // three seconds on, the cubic function is past its plateau and pulls ahead
+      test.execute( Tick { 3000 } );
+      test.execute( Push { string( 1000, 'z' ) } );
+      expect_full_segments( test, 1 );
+      test.execute( AckReceived { isn + 12001 }.with_win( 60000 ) );
+      test.execute( ExpectCwnd { 7553 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "the peer's window still applies", cfg, CongestionControl::Algorithm::Cubic };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 2500 ) );
+      test.execute( Push { string( 10000, 'x' ) } );
+      expect_full_segments( test, 2 );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// SYN and its ack, then ten full segments, of which the first is acknowledged
+static void send_ten( TCPSenderTestHarness& test, Wrap32 isn )
+{
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+  test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+  test.execute( Push { string( 10000, 'x' ) } );
+  for ( size_t i = 0; i < 10; i++ ) {
+    test.execute( ExpectMessage {}.with_payload_size( TCPConfig::MAX_PAYLOAD_SIZE ) );
+  }
+  test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+  test.execute( ExpectCwnd { 11001 } );
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Third duplicate ACK retransmits", cfg, CongestionControl::Algorithm::NewReno };
+      send_ten( test, isn );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1001 ).with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // half the flight, plus the three segments that left the network
+      test.execute( ExpectSsthresh { 4500 } );
+      test.execute( ExpectCwnd { 7500 } );
+
+      // only once
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Window updates are not duplicate ACKs", cfg,
+                                  CongestionControl::Algorithm::NewReno };
+      send_ten( test, isn );
+      test.execute( AckReceived { isn + 1001 }.with_win( 50000 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 49000 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 48000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1001 }.with_win( 48000 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 48000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1001 }.with_win( 48000 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1001 ).with_payload_size( 1000 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "New data restarts the count", cfg, CongestionControl::Algorithm::NewReno };
+      send_ten( test, isn );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( AckReceived { isn + 2001 }.with_win( 60000 ) );
+      test.execute( AckReceived { isn + 2001 }.with_win( 60000 ) );
+      test.execute( AckReceived { isn + 2001 }.with_win( 60000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 2001 }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 2001 ).with_payload_size( 1000 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Fast recovery inflates, and partial ACKs retransmit", cfg,
+                                  CongestionControl::Algorithm::NewReno };
+      send_ten( test, isn );
+      for ( size_t i = 0; i < 3; i++ ) {
+        test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      }
+      test.execute( ExpectMessage {}.with_seqno( isn + 1001 ).with_payload_size( 1000 ) );
+      test.execute( ExpectCwnd { 7500 } );
+
+      // each further duplicate lets one more segment go
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectCwnd { 8500 } );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectCwnd { 10500 } );
+      test.execute( Push { string( 1000, 'y' ) } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 10001 ).with_payload_size( 1000 ) );
+
+      // a partial ACK: the next segment went missing too, and is sent without waiting
+      test.execute( AckReceived { isn + 3001 }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 3001 ).with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCwnd { 9500 } );
+
+      // the full ACK ends recovery, deflating the window
+      test.execute( AckReceived { isn + 10001 }.with_win( 60000 ) );
+      test.execute( ExpectCwnd { 4500 } );
+      test.execute( ExpectNoSegment {} );
+
+      // and a new episode can start
+      test.execute( AckReceived { isn + 10001 }.with_win( 60000 ) );
+      test.execute( AckReceived { isn + 10001 }.with_win( 60000 ) );
+      test.execute( AckReceived { isn + 10001 }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 10001 ).with_payload_size( 1000 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Duplicates with nothing in flight don't count", cfg,
+                                  CongestionControl::Algorithm::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      for ( size_t i = 0; i < 4; i++ ) {
+        test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+      }
+      test.execute( Push { string( 1000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSsthresh { UINT64_MAX } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "The peer's own data segments are not duplicate ACKs", cfg,
+                                  CongestionControl::Algorithm::NewReno };
+      send_ten( test, isn );
+      for ( size_t i = 0; i < 4; i++ ) {
+        test.execute( AckReceived { isn + 1001 }.with_win( 60000 ).carrying_data() );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCwnd { 11001 } );
+      test.execute( ExpectSsthresh { UINT64_MAX } );
+
+      // true duplicates still count from zero
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1001 ).with_payload_size( 1000 ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
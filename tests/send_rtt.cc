@@ -0,0 +1,170 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rto_min_ms = 10;
+
+      TCPSenderTestHarness test { "RTO follows the smoothed RTT", cfg, CongestionControl::Algorithm::None };
+      test.execute( ExpectRTO { 1000 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectSRTT { 40 } );
+      test.execute( ExpectRTTVar { 20 } );
+      test.execute( ExpectRTO { 40 + 4 * 20 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 8 } );
+      test.execute( AckReceived { isn + 4 } );
+      test.execute( ExpectRTTVar { 0.75 * 20 + 0.25 * 32 } );
+      test.execute( ExpectSRTT { 0.875 * 40 + 0.125 * 8 } );
+      test.execute( ExpectRTO { 36 + 4 * 23 } );
+
+      // the timer runs on the new RTO
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( Tick { 127 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( ExpectRTO { 2 * 128 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rto_min_ms = 10;
+
+      TCPSenderTestHarness test { "Karn's rule: no sample from a retransmitted segment", cfg,
+                                  CongestionControl::Algorithm::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( ExpectRTO { 2000 } );
+      test.execute( Tick { 5 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectSRTT { 0 } );
+      test.execute( ExpectRTO { 1000 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { isn + 4 } );
+      test.execute( ExpectSRTT { 20 } );
+      test.execute( ExpectRTO { 60 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rto_min_ms = 10;
+
+      TCPSenderTestHarness test { "Karn's rule: no sample from an ack that covers a retransmission", cfg,
+                                  CongestionControl::Algorithm::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectSRTT { 40 } );
+
+      // "abc" times out and is sent again; "def" goes out once, just before the ack of both
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 120 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( Tick { 5 } );
+      test.execute( AckReceived { isn + 7 } );
+      test.execute( ExpectSRTT { 40 } );
+      test.execute( ExpectRTO { 120 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rto_min_ms = 10;
+
+      TCPSenderTestHarness test { "Karn's rule: no sample from an ack that covers SACKed data", cfg,
+                                  CongestionControl::Algorithm::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { isn + 1 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( AckReceived { isn + 1 }.with_sack( isn + 4, isn + 7 ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 7 } );
+      test.execute( ExpectSRTT { 40 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rto_min_ms = 100;
+      cfg.rto_max_ms = 300;
+
+      TCPSenderTestHarness test { "RTO stays within its bounds", cfg, CongestionControl::Algorithm::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 1 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectRTO { 100 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      for ( const uint64_t rto : { 100, 200, 300, 300 } ) {
+        test.execute( Tick { rto } );
+        test.execute( ExpectMessage {}.with_data( "abc" ) );
+      }
+      test.execute( ExpectRTO { 300 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rtt_estimation = false;
+
+      TCPSenderTestHarness test { "without RTT estimation, the RTO stays put", cfg,
+                                  CongestionControl::Algorithm::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { isn + 1 } );
+      test.execute( ExpectRTO { 1000 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
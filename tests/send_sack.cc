@@ -0,0 +1,173 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "SACKed segments above a hole get it resent at once", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ) );
+      for ( const string data : { "a", "b", "c", "d" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+
+      // two SACKed segments above "a" are not enough
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 2, isn + 4 ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 2, isn + 5 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_data( "a" ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+
+      // only once per recovery episode
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 2, isn + 5 ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( AckReceived { isn + 5 }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "every hole is resent in one episode", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ) );
+      for ( const string data : { "a", "b", "c", "d", "e", "f", "g", "h" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+
+      // "a", "c" and "e" are missing, and each has at least three SACKed segments above it
+      test.execute( AckReceived { isn + 1 }
+                      .with_win( 1000 )
+                      .with_sack( isn + 2, isn + 3 )
+                      .with_sack( isn + 4, isn + 5 )
+                      .with_sack( isn + 6, isn + 9 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_data( "a" ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 3 ).with_data( "c" ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 5 ).with_data( "e" ) );
+      test.execute( ExpectNoSegment {} );
+
+      // a partial ack doesn't resend them again
+      test.execute(
+        AckReceived { isn + 3 }.with_win( 1000 ).with_sack( isn + 4, isn + 5 ).with_sack( isn + 6, isn + 9 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 6 } );
+
+      test.execute( AckReceived { isn + 9 }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "holes beyond the window wait", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ) );
+      for ( const string data : { "a", "b", "c", "d", "e", "f", "g", "h" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+
+      test.execute(
+        AckReceived { isn + 1 }.with_win( 2 ).with_sack( isn + 2, isn + 3 ).with_sack( isn + 4, isn + 9 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_data( "a" ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the window opens, and "c" can go
+      test.execute( AckReceived { isn + 3 }.with_win( 1000 ).with_sack( isn + 4, isn + 9 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 3 ).with_data( "c" ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "a timeout forgets what was SACKed", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ) );
+      for ( const string data : { "a", "b", "c", "d", "e", "f", "g", "h" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+
+      test.execute( AckReceived { isn + 1 }
+                      .with_win( 1000 )
+                      .with_sack( isn + 2, isn + 3 )
+                      .with_sack( isn + 4, isn + 5 )
+                      .with_sack( isn + 6, isn + 9 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_data( "a" ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 3 ).with_data( "c" ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 5 ).with_data( "e" ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_data( "a" ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the receiver has since dropped "d": it goes again with "c" and "e", without waiting for another timeout
+      test.execute( AckReceived { isn + 3 }.with_win( 1000 ).with_sack( isn + 6, isn + 9 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 3 ).with_data( "c" ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 4 ).with_data( "d" ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 5 ).with_data( "e" ) );
+      test.execute( ExpectNoSegment {} );
+
+      test.execute( AckReceived { isn + 9 }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "SACK blocks outside what was sent are ignored", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ) );
+      for ( const string data : { "a", "b", "c", "d" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 2, isn + 10 ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn + 4, isn + 2 ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_sack( isn, isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 4 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
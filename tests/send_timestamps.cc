@@ -0,0 +1,124 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Segments carry the tick clock", cfg, CongestionControl::Algorithm::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_tsval( 0 ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_tsecr( 0 ) );
+      test.execute( ExpectSRTT { 100 } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_tsval( 100 ) );
+
+      // a retransmission is stamped afresh
+      test.execute( Tick { 300 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_tsval( 400 ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Acks of retransmitted data are timed by their echo", cfg,
+                                  CongestionControl::Algorithm::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_tsecr( 0 ) );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 300 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_tsval( 400 ) );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { isn + 4 }.with_win( 1000 ).with_tsecr( 400 ) );
+      test.execute( ExpectSRTT { 0.875 * 100 + 0.125 * 50 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Bogus echoes give no RTT sample", cfg, CongestionControl::Algorithm::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_tsecr( 0 ) );
+      test.execute( ExpectSRTT { 100 } );
+
+      // an echo from the future, and one older than the RTO, would be huge samples: they are ignored
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_tsval( 100 ) );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { isn + 2 }.with_win( 1000 ).with_tsecr( 5000 ) );
+      test.execute( AckReceived { isn + 3 }.with_win( 1000 ).with_tsecr( UINT32_MAX - 5000 ) );
+      test.execute( ExpectSRTT { 100 } );
+      test.execute( AckReceived { isn + 4 }.with_win( 1000 ).with_tsecr( 100 ) );
+      test.execute( ExpectSRTT { 0.875 * 100 + 0.125 * 20 } );
+
+      // and a duplicate ACK acknowledges nothing new to time
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_tsval( 120 ) );
+      test.execute( Tick { 30 } );
+      test.execute( AckReceived { isn + 4 }.with_win( 1000 ).with_tsecr( 120 ) );
+      test.execute( ExpectSRTT { 0.875 * 100 + 0.125 * 20 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Without the echo, Karn's rule holds", cfg, CongestionControl::Algorithm::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ) );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 300 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { isn + 4 }.with_win( 1000 ) );
+      test.execute( ExpectSRTT { 100 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.timestamps = false;
+
+      TCPSenderTestHarness test { "Timestamps can be turned off", cfg, CongestionControl::Algorithm::None };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { isn + 1 }.with_win( 1000 ).with_tsecr( 20 ) );
+      test.execute( ExpectSRTT { 100 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
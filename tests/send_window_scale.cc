@@ -0,0 +1,92 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// SYN, then the peer's SYN-ACK (whose window is never scaled), then a full first segment
+static void connect( TCPSenderTestHarness& test, Wrap32 isn, optional<uint8_t> peer_window_scale )
+{
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+  Receive syn_ack { { isn + 1, 1000 } };
+  if ( peer_window_scale.has_value() ) {
+    syn_ack.with_window_scale( peer_window_scale.value() );
+  }
+  test.execute( syn_ack );
+  test.execute( Push { string( 20000, 'x' ) } );
+  test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_payload_size( 1000 ) );
+  test.execute( ExpectNoSegment {} );
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Windows after the SYN are scaled", cfg, CongestionControl::Algorithm::None };
+      connect( test, isn, 4 );
+      test.execute( AckReceived { isn + 1001 }.with_win( 1000 ) );
+      for ( size_t i = 0; i < 16; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 16000 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.window_scaling = false;
+
+      TCPSenderTestHarness test { "No scaling unless we offered it", cfg, CongestionControl::Algorithm::None };
+      connect( test, isn, 4 );
+      test.execute( AckReceived { isn + 1001 }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "No scaling unless the peer offered it", cfg,
+                                  CongestionControl::Algorithm::None };
+      connect( test, isn, {} );
+      test.execute( AckReceived { isn + 1001 }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "The shift is capped at 14", cfg, CongestionControl::Algorithm::None };
+      connect( test, isn, 20 );
+      test.execute( AckReceived { isn + 1001 }.with_win( 1 ) );
+      for ( size_t i = 0; i < 16; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      test.execute( ExpectSeqnosInFlight { 16384 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#include "buffer_pool.hh"
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+struct ExpectAvailableCapacity : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "writer().available_capacity()"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.first.writer().available_capacity(); }
+};
+
+struct ExpectPoolInUse : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "BufferPool::global().in_use()"; }
+  uint64_t value( StreamAndSender& /* ss */ ) const override { return BufferPool::global().in_use(); }
+};
+
+int main()
+{
+  constexpr uint64_t page = BufferPool::page_size;
+
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.send_capacity = 4 * page;
+
+      // Segments are slices of the outbound stream's page: the stream pops the bytes, but the page stays in
+      // use (one copy of the bytes), and the bytes count against the stream's capacity, until acknowledged.
+      TCPSenderTestHarness test { "unacknowledged bytes stay in the stream's page and capacity", cfg,
+                                  CongestionControl::Algorithm::None, ByteStream::Storage::Paged };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+
+      test.execute( Push { string( 3000, 'x' ) } );
+      for ( uint32_t offset = 1; offset < 3001; offset += 1000 ) {
+        test.execute( ExpectMessage {}.with_seqno( isn + offset ).with_payload_size( 1000 ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectAvailableCapacity { 4 * page - 3000 } );
+      test.execute( ExpectPoolInUse { page } );
+
+      // the retransmission is the same slice
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_payload_size( 1000 ) );
+      test.execute( ExpectPoolInUse { page } );
+
+      test.execute( AckReceived { isn + 2001 }.with_win( 60000 ) );
+      test.execute( ExpectAvailableCapacity { 4 * page - 1000 } );
+      test.execute( ExpectPoolInUse { page } );
+      test.execute( AckReceived { isn + 3001 }.with_win( 60000 ) );
+      test.execute( ExpectAvailableCapacity { 4 * page } );
+      test.execute( ExpectPoolInUse { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.send_capacity = 2000;
+
+      // the writer can't get ahead of the acknowledgments by more than the capacity
+      TCPSenderTestHarness test { "unacknowledged bytes hold back the writer", cfg,
+                                  CongestionControl::Algorithm::None, ByteStream::Storage::Paged };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ) );
+      test.execute( AckReceived { isn + 1 }.with_win( 60000 ) );
+
+      test.execute( Push { string( 1500, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ) );
+      test.execute( Push { string( 1000, 'y' ) } );
+      test.execute( ExpectMessage {}.with_data( string( 500, 'y' ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectAvailableCapacity { 0 } );
+
+      test.execute( AckReceived { isn + 1001 }.with_win( 60000 ) );
+      test.execute( ExpectAvailableCapacity { 1000 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -61,6 +61,41 @@ struct ExpectConsecutiveRetransmissions : public ExpectNumber<StreamAndSender, u
   uint64_t value( StreamAndSender& ss ) const override { return ss.second.consecutive_retransmissions(); }
 };
 
+struct ExpectCwnd : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "cwnd"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.cwnd(); }
+};
+
+struct ExpectSsthresh : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "ssthresh"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.ssthresh(); }
+};
+
+struct ExpectRTO : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "current_RTO_ms"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.current_RTO_ms(); }
+};
+
+struct ExpectSRTT : public ExpectNumber<StreamAndSender, double>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "srtt_ms"; }
+  double value( StreamAndSender& ss ) const override { return ss.second.rtt().srtt_ms(); }
+};
+
+struct ExpectRTTVar : public ExpectNumber<StreamAndSender, double>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rttvar_ms"; }
+  double value( StreamAndSender& ss ) const override { return ss.second.rtt().rttvar_ms(); }
+};
+
 struct ExpectNoSegment : public Expectation<StreamAndSender>
 {
   std::string description() const override { return "nothing to send"; }
@@ -156,12 +191,29 @@ struct Receive : public Action<StreamAndSender>
 {
   TCPReceiverMessage msg_;
   bool push_ = true;
+  bool carried_data_ {};
 
   explicit Receive( TCPReceiverMessage msg ) : msg_( msg ) {}
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    for ( const auto& block : msg_.sack_blocks ) {
+      desc << ", sack=[" << block.left_edge << ", " << block.right_edge << ")";
+    }
+    if ( msg_.mss.has_value() ) {
+      desc << ", mss=" << msg_.mss.value();
+    }
+    if ( msg_.window_scale.has_value() ) {
+      desc << ", wscale=" << static_cast<int>( msg_.window_scale.value() );
+    }
+    if ( msg_.tsecr.has_value() ) {
+      desc << ", tsecr=" << msg_.tsecr.value();
+    }
+    desc << ")";
+    if ( carried_data_ ) {
+      desc << " on a segment carrying data";
+    }
     if ( push_ ) {
       desc << ", then push stream to TCPSender";
     }
@@ -176,17 +228,47 @@ struct Receive : public Action<StreamAndSender>
 
   void execute( StreamAndSender& ss ) const override
   {
-    ss.second.receive( msg_ );
+    ss.second.receive( msg_, carried_data_ );
     if ( push_ ) {
       ss.second.push( ss.first.reader() );
     }
   }
 
+  Receive& with_sack( Wrap32 left_edge, Wrap32 right_edge )
+  {
+    msg_.sack_blocks.push_back( { left_edge, right_edge } );
+    return *this;
+  }
+
+  Receive& with_mss( uint16_t mss )
+  {
+    msg_.mss = mss;
+    return *this;
+  }
+
+  Receive& with_tsecr( uint32_t tsecr )
+  {
+    msg_.tsecr = tsecr;
+    return *this;
+  }
+
+  Receive& with_window_scale( uint8_t shift )
+  {
+    msg_.window_scale = shift;
+    return *this;
+  }
+
   Receive& without_push()
   {
     push_ = false;
     return *this;
   }
+
+  Receive& carrying_data()
+  {
+    carried_data_ = true;
+    return *this;
+  }
 };
 
 struct AckReceived : public Receive
@@ -206,6 +288,7 @@ struct ExpectMessage : public Expectation<StreamAndSender>
   std::optional<Wrap32> seqno {};
   std::optional<std::string> data {};
   std::optional<size_t> payload_size {};
+  std::optional<uint32_t> tsval {};
 
   ExpectMessage& with_syn( bool syn_ )
   {
@@ -246,6 +329,12 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     return *this;
   }
 
+  ExpectMessage& with_tsval( uint32_t tsval_ )
+  {
+    tsval = tsval_;
+    return *this;
+  }
+
   std::string message_description() const
   {
     std::ostringstream o;
@@ -268,6 +357,9 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     if ( fin.has_value() ) {
       o << ( fin.value() ? " +FIN" : " (no FIN)" );
     }
+    if ( tsval.has_value() ) {
+      o << " tsval=" << tsval.value();
+    }
     return o.str();
   }
 
@@ -297,7 +389,10 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     if ( payload_size.has_value() and seg.payload.size() != payload_size.value() ) {
       throw ExpectationViolation( "payload_size", payload_size.value(), seg.payload.size() );
     }
-    if ( seg.payload.size() > TCPConfig::MAX_PAYLOAD_SIZE ) {
+    if ( tsval.has_value() and seg.tsval != tsval ) {
+      throw ExpectationViolation( "tsval", tsval, seg.tsval );
+    }
+    if ( seg.payload.size() > ss.second.mss() ) {
       throw ExpectationViolation( "payload has length (" + std::to_string( seg.payload.size() )
                                   + ") greater than the maximum" );
     }
@@ -316,4 +411,37 @@ public:
                    "initial_RTO_ms=" + to_string( config.rt_timeout ),
                    { ByteStream { config.send_capacity }, TCPSender { config.rt_timeout, config.fixed_isn } } )
   {}
+
+  // A sender built from the whole TCPConfig, with the given congestion control
+  TCPSenderTestHarness( std::string name, TCPConfig config, CongestionControl::Algorithm congestion_control )
+    : TestHarness( move( name ),
+                   "initial_RTO_ms=" + to_string( config.rt_timeout ),
+                   { ByteStream { config.send_capacity },
+                     TCPSender { with_algorithm( config, congestion_control ) } } )
+  {}
+
+  // The same, with the outbound stream stored and retaining unacknowledged bytes like TCPPeer's
+  TCPSenderTestHarness( std::string name,
+                        TCPConfig config,
+                        CongestionControl::Algorithm congestion_control,
+                        ByteStream::Storage storage )
+    : TestHarness( move( name ),
+                   "initial_RTO_ms=" + to_string( config.rt_timeout ),
+                   { retaining( config.send_capacity, storage ),
+                     TCPSender { with_algorithm( config, congestion_control ) } } )
+  {}
+
+private:
+  static TCPConfig with_algorithm( TCPConfig config, CongestionControl::Algorithm congestion_control )
+  {
+    config.congestion_control = congestion_control;
+    return config;
+  }
+
+  static ByteStream retaining( uint64_t capacity, ByteStream::Storage storage )
+  {
+    ByteStream stream { capacity, storage };
+    stream.reader().retain_popped( true );
+    return stream;
+  }
 };
@@ -0,0 +1,238 @@
+#include "checksum.hh"
+#include "conversions.hh"
+#include "parser.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr uint32_t pseudo_checksum = 0x1234;
+
+// serialize a segment, as it would be sent, and parse it back
+static TCPSegment round_trip( TCPSegment segment )
+{
+  segment.compute_checksum( pseudo_checksum );
+  TCPSegment parsed;
+  if ( not parse( parsed, serialize( segment ), pseudo_checksum ) ) {
+    throw runtime_error( "segment did not parse" );
+  }
+  if ( string_view { parsed.sender_message.payload } != string_view { segment.sender_message.payload } ) {
+    throw runtime_error( "payload changed in the round trip" );
+  }
+  return parsed;
+}
+
+// every segment a peer has to send
+static vector<TCPSegment> send_all( TCPPeer& peer )
+{
+  vector<TCPSegment> segments;
+  while ( auto segment = peer.maybe_send() ) {
+    segments.push_back( move( segment.value() ) );
+  }
+  return segments;
+}
+
+template<typename T>
+static void expect( const string& name, const T& expected, const T& actual )
+{
+  if ( expected != actual ) {
+    throw runtime_error( name + " should have been " + to_string( expected ) + ", but was " + to_string( actual ) );
+  }
+}
+
+int main()
+{
+  try {
+    {
+      TCPSegment segment;
+      segment.sender_message.payload = string { "hello" };
+      expect( "header length", size_t { 20 }, serialize( segment ).front().size() );
+      const TCPSegment parsed = round_trip( segment );
+      expect( "sack_permitted", false, parsed.receiver_message.sack_permitted );
+      expect( "sack_blocks", vector<SACKBlock> {}, parsed.receiver_message.sack_blocks );
+    }
+
+    {
+      TCPSegment segment;
+      segment.sender_message.SYN = true;
+      segment.receiver_message.sack_permitted = true;
+      expect( "sack_permitted", true, round_trip( segment ).receiver_message.sack_permitted );
+
+      // only offered along with a SYN
+      segment.sender_message.SYN = false;
+      expect( "sack_permitted", false, round_trip( segment ).receiver_message.sack_permitted );
+    }
+
+    {
+      TCPSegment segment;
+      segment.sender_message.SYN = true;
+      segment.receiver_message.mss = 8960;
+      segment.receiver_message.sack_permitted = true;
+      expect( "header length", size_t { 28 }, serialize( segment ).front().size() );
+      const TCPSegment parsed = round_trip( segment );
+      expect( "mss", uint16_t { 8960 }, parsed.receiver_message.mss.value_or( 0 ) );
+      expect( "sack_permitted", true, parsed.receiver_message.sack_permitted );
+      expect( "window_scale present", false, parsed.receiver_message.window_scale.has_value() );
+
+      segment.receiver_message.window_scale = 7;
+      expect( "header length", size_t { 32 }, serialize( segment ).front().size() );
+      expect( "window_scale", 7, int { round_trip( segment ).receiver_message.window_scale.value_or( 0 ) } );
+
+      // only announced along with a SYN
+      segment.sender_message.SYN = false;
+      expect( "mss present", false, round_trip( segment ).receiver_message.mss.has_value() );
+      expect( "window_scale present", false, round_trip( segment ).receiver_message.window_scale.has_value() );
+    }
+
+    {
+      TCPSegment segment;
+      segment.sender_message.payload = string { "data after the options" };
+      segment.receiver_message.ackno = Wrap32 { 1000 };
+      segment.receiver_message.sack_blocks = { { Wrap32 { 2000 }, Wrap32 { 3000 } },
+                                               { Wrap32 { UINT32_MAX - 5 }, Wrap32 { 10 } } };
+      const TCPSegment parsed = round_trip( segment );
+      expect( "ackno", segment.receiver_message.ackno, parsed.receiver_message.ackno );
+      expect( "sack_blocks", segment.receiver_message.sack_blocks, parsed.receiver_message.sack_blocks );
+
+      // SACK blocks need an ackno
+      segment.receiver_message.ackno.reset();
+      expect( "sack_blocks", vector<SACKBlock> {}, round_trip( segment ).receiver_message.sack_blocks );
+    }
+
+    {
+      TCPSegment segment;
+      segment.receiver_message.ackno = Wrap32 { 1 };
+      for ( uint32_t i = 0; i < 6; i++ ) {
+        segment.receiver_message.sack_blocks.push_back( { Wrap32 { 10 * i + 5 }, Wrap32 { 10 * i + 8 } } );
+      }
+      const TCPSegment parsed = round_trip( segment );
+      expect( "number of sack_blocks",
+              TCPReceiverMessage::MAX_SACK_BLOCKS,
+              parsed.receiver_message.sack_blocks.size() );
+      expect( "first SACK block",
+              segment.receiver_message.sack_blocks.front(),
+              parsed.receiver_message.sack_blocks.front() );
+    }
+
+    {
+      TCPSegment segment;
+      segment.sender_message.tsval = 123456;
+      segment.receiver_message.ackno = Wrap32 { 1 };
+      segment.receiver_message.tsecr = 654321;
+      TCPSegment parsed = round_trip( segment );
+      expect( "tsval", segment.sender_message.tsval, parsed.sender_message.tsval );
+      expect( "tsecr", segment.receiver_message.tsecr, parsed.receiver_message.tsecr );
+
+      // timestamps leave room for three SACK blocks
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        segment.receiver_message.sack_blocks.push_back( { Wrap32 { 10 * i + 5 }, Wrap32 { 10 * i + 8 } } );
+      }
+      parsed = round_trip( segment );
+      expect( "number of sack_blocks", size_t { 3 }, parsed.receiver_message.sack_blocks.size() );
+      expect( "tsecr", segment.receiver_message.tsecr, parsed.receiver_message.tsecr );
+
+      // the echo needs an ackno
+      segment.receiver_message.ackno.reset();
+      parsed = round_trip( segment );
+      expect( "tsval", segment.sender_message.tsval, parsed.sender_message.tsval );
+      expect( "tsecr present", false, parsed.receiver_message.tsecr.has_value() );
+    }
+
+    {
+      // options this implementation doesn't know are skipped
+      TCPSegment segment;
+      segment.sender_message.payload = string { "xyz" };
+      segment.receiver_message.ackno = Wrap32 { 77 };
+      string header = serialize( segment ).front();
+      header[12] = static_cast<char>( 9 << 4 );               // data offset: 36 bytes
+      header += string { static_cast<char>( 253 ), 4, 0, 0 }; // experimental option
+      header += string { 1, 5, 10, 0, 0, 0, 1, 0, 0, 0, 2 };  // NOP, and a SACK block
+      header += string { 0 };                                 // end of options
+
+      const auto parse_with_checksum = [&]( TCPSegment& parsed ) {
+        header[16] = header[17] = 0;
+        InternetChecksum check { pseudo_checksum };
+        check.add( header );
+        check.add( segment.sender_message.payload );
+        header[16] = static_cast<char>( check.value() >> 8 );
+        header[17] = static_cast<char>( check.value() & 0xff );
+        return parse( parsed, { header, segment.sender_message.payload }, pseudo_checksum );
+      };
+
+      TCPSegment parsed;
+      if ( not parse_with_checksum( parsed ) ) {
+        throw runtime_error( "segment with unknown options did not parse" );
+      }
+      if ( string_view { parsed.sender_message.payload } != "xyz" ) {
+        throw runtime_error( "payload should have followed the options" );
+      }
+      expect(
+        "sack_blocks", vector<SACKBlock> { { Wrap32 { 1 }, Wrap32 { 2 } } }, parsed.receiver_message.sack_blocks );
+
+      // an option running past the header is an error
+      header[21] = 40;
+      if ( parse_with_checksum( parsed ) ) {
+        throw runtime_error( "segment with a malformed option parsed" );
+      }
+    }
+
+    {
+      // the MSS counts the options: with timestamps and SACK blocks, payloads shrink to leave room for them
+      TCPConfig cfg;
+      cfg.mss = 536;
+      TCPPeer client { cfg };
+      TCPPeer server { cfg };
+      const auto segment_size = []( const TCPSegment& segment ) {
+        return serialize( segment ).front().size() - 20 + segment.sender_message.payload.size();
+      };
+
+      client.push();
+      for ( int i = 0; i < 2; i++ ) {
+        for ( auto& segment : send_all( client ) ) {
+          server.receive( move( segment ) );
+        }
+        for ( auto& segment : send_all( server ) ) {
+          client.receive( move( segment ) );
+        }
+      }
+      expect( "server has ackno", true, server.has_ackno() );
+
+      // the client's data carries timestamps; losing every other segment leaves the server three holes
+      client.outbound_writer().push( string( 8 * 524, 'c' ) );
+      client.push();
+      auto segments = send_all( client );
+      expect( "client segments", size_t { 8 }, segments.size() );
+      for ( size_t i = 0; i < segments.size(); i++ ) {
+        expect( "client segment size", size_t { 536 }, segment_size( segments[i] ) );
+        if ( i % 2 == 1 ) {
+          server.receive( move( segments[i] ) );
+        }
+      }
+
+      // the server's data carries the three SACK blocks as well
+      server.outbound_writer().push( string( 2000, 's' ) );
+      server.push();
+      segments = send_all( server );
+      expect( "server segments", size_t { 4 }, segments.size() );
+      for ( const auto& segment : segments ) {
+        expect( "sack_blocks", size_t { 3 }, round_trip( segment ).receiver_message.sack_blocks.size() );
+        if ( segment_size( segment ) > 536 ) {
+          throw runtime_error( "segment of " + to_string( segment_size( segment ) ) + " bytes exceeds the MSS" );
+        }
+      }
+      expect( "server payload", size_t { 536 - 36 }, segments.front().sender_message.payload.size() );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,23 +1,77 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 
 class Buffer
 {
   std::shared_ptr<std::string> buffer_;
 
+  // A Buffer can also borrow bytes it doesn't own as a string (a slice of another Buffer, or
+  // memory such as a mapped file); `owner_` keeps that memory alive. Borrowed bytes are read-only:
+  // asking for a mutable string copies them into one of the Buffer's own first.
+  std::shared_ptr<const void> owner_ {};
+  std::string_view borrowed_ {};
+
+  void own()
+  {
+    if ( owner_ ) {
+      buffer_ = std::make_shared<std::string>( borrowed_ );
+      owner_.reset();
+      borrowed_ = {};
+    }
+  }
+
 public:
   // NOLINTBEGIN(*-explicit-*)
 
   Buffer( std::string str = {} ) : buffer_( make_shared<std::string>( std::move( str ) ) ) {}
-  operator std::string_view() const { return *buffer_; }
-  operator std::string&() { return *buffer_; }
+  operator std::string_view() const { return owner_ ? borrowed_ : std::string_view { *buffer_ }; }
+  operator std::string&()
+  {
+    own();
+    return *buffer_;
+  }
 
   // NOLINTEND(*-explicit-*)
 
-  std::string&& release() { return std::move( *buffer_ ); }
-  size_t size() const { return buffer_->size(); }
-  size_t length() const { return buffer_->length(); }
-  bool empty() const { return buffer_->empty(); }
+  // Borrow `bytes`, which `owner` keeps alive
+  Buffer( std::shared_ptr<const void> owner, std::string_view bytes )
+    : buffer_(), owner_( std::move( owner ) ), borrowed_( bytes )
+  {}
+
+  // A Buffer of `len` bytes starting at `pos` that shares this one's storage instead of copying it
+  // (so this Buffer's string must not be modified while the slice is in use)
+  Buffer substr( size_t pos, size_t len = std::string::npos ) const
+  {
+    const std::string_view bytes = std::string_view { *this }.substr( pos, len );
+    if ( bytes.size() == size() ) {
+      return *this;
+    }
+    return { owner_ ? owner_ : buffer_, bytes };
+  }
+
+  // If `next` continues this Buffer's bytes in the same storage, one slice of both (no copy)
+  std::optional<Buffer> joined( const Buffer& next ) const
+  {
+    const std::string_view bytes { *this };
+    const std::string_view next_bytes { next };
+    const void* storage = owner_ ? owner_.get() : buffer_.get();
+    const void* next_storage = next.owner_ ? next.owner_.get() : next.buffer_.get();
+    if ( storage != next_storage or bytes.data() + bytes.size() != next_bytes.data() ) {
+      return {};
+    }
+    return Buffer { owner_ ? owner_ : buffer_, { bytes.data(), bytes.size() + next_bytes.size() } };
+  }
+
+  std::string&& release()
+  {
+    own();
+    return std::move( *buffer_ );
+  }
+  size_t size() const { return std::string_view { *this }.size(); }
+  size_t length() const { return size(); }
+  bool empty() const { return size() == 0; }
 };
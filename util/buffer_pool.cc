@@ -0,0 +1,45 @@
+#include "buffer_pool.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+BufferPool::BufferPool( uint64_t budget ) : state_( make_shared<State>( budget ) ) {}
+
+BufferPool& BufferPool::global()
+{
+  static BufferPool pool { default_budget };
+  return pool;
+}
+
+shared_ptr<char> BufferPool::allocate()
+{
+  unique_ptr<char[]> page; // NOLINT(*-avoid-c-arrays)
+  {
+    const lock_guard lock { state_->mutex };
+    if ( not state_->free_pages.empty() ) {
+      page = move( state_->free_pages.back() );
+      state_->free_pages.pop_back();
+    }
+  }
+  if ( not page ) {
+    page = make_unique_for_overwrite<char[]>( page_size ); // NOLINT(*-avoid-c-arrays)
+  }
+
+  state_->in_use += page_size;
+  return { page.release(), [state = state_]( char* data ) {
+            unique_ptr<char[]> returned { data }; // NOLINT(*-avoid-c-arrays)
+            state->in_use -= page_size;
+            const lock_guard lock { state->mutex };
+            if ( state->free_pages.size() < max_free_pages ) {
+              state->free_pages.push_back( move( returned ) );
+            }
+          } };
+}
+
+uint64_t BufferPool::available() const
+{
+  const uint64_t budget = state_->budget;
+  const uint64_t in_use = state_->in_use;
+  return budget - min( budget, in_use );
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//! A pool of fixed-size pages shared by every paged ByteStream in the process, with a byte budget.
+//! Pages are refcounted: one goes back to the pool when the last stream or Buffer using it lets go.
+//! The budget is advisory: allocate() always succeeds, but paged streams shrink their available
+//! capacity as the pool approaches its budget, so the total stays near it.
+class BufferPool
+{
+  struct State
+  {
+    std::mutex mutex {};
+    std::vector<std::unique_ptr<char[]>> free_pages {}; // NOLINT(*-avoid-c-arrays)
+    std::atomic<uint64_t> budget;
+    std::atomic<uint64_t> in_use {};
+
+    explicit State( uint64_t initial_budget ) : budget( initial_budget ) {}
+  };
+
+  std::shared_ptr<State> state_; // shared with every outstanding page, so pages may outlive the pool
+
+public:
+  static constexpr uint64_t page_size = 16384;
+  static constexpr uint64_t max_free_pages = 256; // free pages kept for reuse instead of being released
+  static constexpr uint64_t default_budget = 64 * 1024 * 1024;
+
+  explicit BufferPool( uint64_t budget );
+
+  //! The pool used by ByteStream::Storage::Paged
+  static BufferPool& global();
+
+  //! A page of `page_size` bytes, returned to the pool when the last copy of the pointer goes away
+  std::shared_ptr<char> allocate();
+
+  uint64_t budget() const { return state_->budget; }
+  void set_budget( uint64_t budget ) { state_->budget = budget; }
+
+  uint64_t in_use() const { return state_->in_use; } // bytes in pages handed out and not yet returned
+  uint64_t available() const;                        // bytes left under the budget
+};
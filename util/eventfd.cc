@@ -0,0 +1,25 @@
+#include "eventfd.hh"
+#include "exception.hh"
+
+#include <cerrno>
+#include <sys/eventfd.h>
+
+EventFD::EventFD() : FileDescriptor( ::CheckSystemCall( "eventfd", eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) ) {}
+
+void EventFD::notify()
+{
+  CheckSystemCall( "eventfd_write", eventfd_write( fd_num(), 1 ) );
+  register_write();
+}
+
+void EventFD::clear()
+{
+  eventfd_t value {};
+  if ( eventfd_read( fd_num(), &value ) < 0 ) {
+    if ( errno == EAGAIN ) {
+      return; // already clear
+    }
+    throw unix_error { "eventfd_read" };
+  }
+  register_read();
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+//! A FileDescriptor to a non-blocking [eventfd](\ref man2::eventfd), used to wake up another thread's EventLoop
+class EventFD : public FileDescriptor
+{
+public:
+  //! Create an eventfd with a zero counter
+  EventFD();
+
+  //! Make the eventfd readable (add one to its counter)
+  void notify();
+
+  //! Reset the counter, so the eventfd stops being readable until the next notify()
+  void clear();
+};
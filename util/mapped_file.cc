@@ -0,0 +1,57 @@
+#include "mapped_file.hh"
+
+#include "exception.hh"
+
+#include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static struct stat file_status( const FileDescriptor& fd )
+{
+  struct stat st
+  {};
+  CheckSystemCall( "fstat", fstat( fd.fd_num(), &st ) );
+  return st;
+}
+
+bool MappedFile::mappable( const FileDescriptor& fd )
+{
+  return S_ISREG( file_status( fd ).st_mode );
+}
+
+MappedFile::MappedFile( const FileDescriptor& fd ) : mapping_()
+{
+  const struct stat st = file_status( fd );
+  if ( not S_ISREG( st.st_mode ) ) {
+    throw runtime_error( "MappedFile: not a regular file" );
+  }
+
+  const auto size = static_cast<size_t>( st.st_size );
+  if ( size == 0 ) {
+    mapping_ = make_shared<Mapping>( nullptr, 0 ); // mmap() refuses empty mappings
+    return;
+  }
+
+  void* data = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd.fd_num(), 0 );
+  if ( data == MAP_FAILED ) {
+    throw unix_error { "mmap" };
+  }
+  madvise( data, size, MADV_SEQUENTIAL );
+  mapping_ = make_shared<Mapping>( static_cast<const char*>( data ), size );
+}
+
+MappedFile::Mapping::~Mapping()
+{
+  if ( data_ and munmap( const_cast<char*>( data_ ), size_ ) != 0 ) { // NOLINT(*-const-cast)
+    cerr << "Exception destructing MappedFile: " << unix_error { "munmap" }.what() << "\n";
+  }
+}
+
+Buffer MappedFile::slice( size_t offset, size_t len ) const
+{
+  const string_view contents { mapping_->data_, mapping_->size_ };
+  return { mapping_, contents.substr( offset, len ) };
+}
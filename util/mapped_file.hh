@@ -0,0 +1,44 @@
+#pragma once
+
+#include "buffer.hh"
+#include "file_descriptor.hh"
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+//! A read-only [mmap(2)](\ref man2::mmap) of a whole regular file. Slices of it are Buffers that
+//! borrow the mapping, so file contents can travel through a Chunked ByteStream, and into the
+//! segments a TCPSender reads from one, without being copied; the mapping is released when the
+//! last slice goes away. (TCPPeer's own streams are Paged: pushing slices into those copies them.)
+class MappedFile
+{
+  class Mapping
+  {
+  public:
+    const char* data_;
+    size_t size_;
+
+    Mapping( const char* data, size_t size ) : data_( data ), size_( size ) {}
+    ~Mapping();
+
+    Mapping( const Mapping& other ) = delete;
+    Mapping& operator=( const Mapping& other ) = delete;
+    Mapping( Mapping&& other ) = delete;
+    Mapping& operator=( Mapping&& other ) = delete;
+  };
+
+  std::shared_ptr<Mapping> mapping_;
+
+public:
+  //! Map the file open on `fd` (which must be a regular file)
+  explicit MappedFile( const FileDescriptor& fd );
+
+  //! Is `fd` a regular file that can be mapped?
+  static bool mappable( const FileDescriptor& fd );
+
+  size_t size() const { return mapping_->size_; }
+
+  //! Up to `len` bytes starting at `offset`, sharing the mapping
+  Buffer slice( size_t offset, size_t len ) const;
+};
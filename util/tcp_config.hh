@@ -1,6 +1,8 @@
 #pragma once
 
 #include "address.hh"
+#include "congestion_control.hh"
+#include "reassembler.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -15,11 +17,34 @@ public:
   static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
   static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
   static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
+  static constexpr uint64_t RTO_MIN_DFLT = 200;     //!< Default lower bound on an adapted RTO, in milliseconds
+  static constexpr uint64_t RTO_MAX_DFLT = 60000;   //!< Default upper bound on the RTO, in milliseconds
+  static constexpr uint8_t MAX_WINDOW_SHIFT = 14;   //!< Largest window scale allowed (RFC 7323)
 
   uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
+  bool rtt_estimation = true;              //!< Adapt the retransmission timeout to measured RTTs (RFC 6298)
+  uint64_t rto_min_ms = RTO_MIN_DFLT;      //!< Lower bound on the adapted retransmission timeout
+  uint64_t rto_max_ms = RTO_MAX_DFLT;      //!< Upper bound on the retransmission timeout, backoff included
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
+  uint16_t mss = MAX_PAYLOAD_SIZE;         //!< Largest payload plus options to send and accept (on the SYN)
   std::optional<Wrap32> fixed_isn {};
+  bool sack = true; //!< Offer SACK on the SYN, and send SACK blocks if the peer offers it too
+  bool fast_retransmit = true; //!< Retransmit after DUP_THRESH duplicate ACKs, and fast recovery (RFC 6582)
+  bool window_scaling = true;  //!< Offer window scaling (RFC 7323) on the SYN, and scale if the peer does too
+  bool timestamps = true;      //!< Offer timestamps (RFC 7323) on the SYN, and send them if the peer does too
+  CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::NewReno; //!< Sender's cwnd
+  Reassembler::Engine reassembler_engine = Reassembler::Engine::Map; //!< How the receiver holds out-of-order data
+
+  //! The window scale to offer: just enough to advertise all of recv_capacity
+  uint8_t window_shift() const
+  {
+    uint8_t shift = 0;
+    while ( shift < MAX_WINDOW_SHIFT and ( recv_capacity >> shift ) > UINT16_MAX ) {
+      shift++;
+    }
+    return shift;
+  }
 };
 
 //! Config for classes derived from FdAdapter
@@ -20,6 +20,10 @@ using namespace std;
 
 static constexpr size_t TCP_TICK_MS = 10;
 
+// Wait for this much room in the outbound stream (or all of it, if smaller) before reading more from the
+// application, rather than waking up for every byte the peer acknowledges
+static constexpr uint64_t OUTBOUND_HIGH_WATERMARK = 16384;
+
 static inline uint64_t timestamp_ms()
 {
   static_assert( std::is_same<std::chrono::steady_clock::duration, std::chrono::nanoseconds>::value );
@@ -69,6 +73,7 @@ template<typename AdaptT>
 void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
 {
   _tcp.emplace( config );
+  _tcp->outbound_writer().set_watermarks( 1, OUTBOUND_HIGH_WATERMARK );
 
   // Set up the event loop
 
@@ -114,10 +119,9 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     _thread_data,
     Direction::In,
     [&] {
-      string data;
-      data.resize( _tcp->outbound_writer().available_capacity() );
-      _thread_data.read( data );
-      _tcp->outbound_writer().push( move( data ) );
+      // read straight into the outbound stream's free space
+      Writer& outbound = _tcp->outbound_writer();
+      outbound.commit( _thread_data.read( outbound.reserve( outbound.available_capacity() ) ) );
 
       if ( _thread_data.eof() ) {
         _tcp->outbound_writer().close();
@@ -132,10 +136,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       _tcp->push();
       collect_segments();
     },
-    [&] {
-      return ( _tcp->active() ) and ( not _outbound_shutdown )
-             and ( _tcp->outbound_writer().available_capacity() > 0 );
-    },
+    [&] { return ( _tcp->active() ) and ( not _outbound_shutdown ) and _tcp->outbound_writer().is_ready(); },
     [&] {
       _tcp->outbound_writer().close();
       _outbound_shutdown = true;
@@ -148,12 +149,11 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     Direction::Out,
     [&] {
       Reader& inbound = _tcp->inbound_reader();
-      // Write from the inbound_stream into
-      // the pipe, handling the possibility of a partial
+      // Write everything buffered in the inbound_stream into
+      // the pipe with a single writev, handling the possibility of a partial
       // write (i.e., only pop what was actually written).
       if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
+        const auto bytes_written = _thread_data.write( inbound.peek_all() );
         inbound.pop( bytes_written );
       }
 
@@ -167,9 +167,9 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       }
     },
     [&] {
-      return _tcp->inbound_reader().bytes_buffered()
-             or ( ( _tcp->inbound_reader().is_finished() or _tcp->inbound_reader().has_error() )
-                  and not _inbound_shutdown );
+      // ready: bytes are buffered, or the stream has finished or failed (which must be passed on once)
+      return _tcp->inbound_reader().is_ready()
+             and ( _tcp->inbound_reader().bytes_buffered() or not _inbound_shutdown );
     } );
 
   // rule 4: read outbound segments from TCPConnection and send as datagrams
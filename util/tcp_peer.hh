@@ -7,26 +7,45 @@
 #include "tcp_sender.hh"
 #include "tcp_sender_message.hh"
 
+#include <algorithm>
+#include <cstdint>
 #include <optional>
 
 class TCPPeer
 {
   TCPConfig cfg_;
-  TCPSender sender_ { cfg_.rt_timeout, cfg_.fixed_isn };
+  TCPSender sender_ { cfg_ };
   TCPReceiver receiver_ {};
-  Reassembler reassembler_ {};
+  Reassembler reassembler_ { cfg_.reassembler_engine };
 
-  ByteStream outbound_stream_ { cfg_.send_capacity }, inbound_stream_ { cfg_.recv_capacity };
+  // stream memory comes from the process-wide BufferPool, so idle connections hold none. The outbound
+  // stream retains what the sender has read until it is acknowledged: segments are slices of its pages,
+  // and counting them against send_capacity keeps this connection's send memory within it.
+  ByteStream outbound_stream_ { cfg_.send_capacity, ByteStream::Storage::Paged };
+  ByteStream inbound_stream_ { cfg_.recv_capacity, ByteStream::Storage::Paged };
 
   bool need_send_ {};
+  bool peer_sack_permitted_ {}; // the peer's SYN offered SACK
+  bool peer_window_scaling_ {}; // the peer's SYN offered window scaling
+  bool peer_timestamps_ {};     // the peer's SYN carried a timestamp
+
+  bool sending_sack_() const { return cfg_.sack and peer_sack_permitted_; }
+  bool sending_timestamps_() const { return cfg_.timestamps and peer_timestamps_; }
 
 public:
-  explicit TCPPeer( const TCPConfig& cfg ) : cfg_( cfg ) {}
+  explicit TCPPeer( const TCPConfig& cfg ) : cfg_( cfg ) { outbound_stream_.reader().retain_popped( true ); }
 
   Writer& outbound_writer() { return outbound_stream_.writer(); }
   Reader& inbound_reader() { return inbound_stream_.reader(); }
 
-  void push() { sender_.push( outbound_stream_.reader() ); };
+  void push()
+  {
+    // payloads leave room for the options that go with them: the MSS counts those too (RFC 6691)
+    const size_t sack_blocks
+      = sending_sack_() ? reassembler_.held_intervals( TCPReceiverMessage::MAX_SACK_BLOCKS ).size() : 0;
+    sender_.set_options_length( TCPSegment::data_options_length( sending_timestamps_(), sack_blocks ) );
+    sender_.push( outbound_stream_.reader() );
+  };
   void tick( uint64_t ms_since_last_tick ) { sender_.tick( ms_since_last_tick ); }
 
   bool has_ackno() const { return receiver_.send( inbound_stream_.writer() ).ackno.has_value(); }
@@ -47,8 +66,23 @@ public:
       return;
     }
 
-    // Give incoming TCPReceiverMessage to sender.
-    sender_.receive( seg.receiver_message );
+    // an old duplicate (PAWS) reaches neither half, lest its stale ack or window count: it only gets an ack
+    if ( receiver_.is_old_duplicate( seg.sender_message ) ) {
+      need_send_ = true;
+      return;
+    }
+
+    if ( seg.sender_message.SYN ) {
+      peer_sack_permitted_ = seg.receiver_message.sack_permitted;
+      peer_window_scaling_ = seg.receiver_message.window_scale.has_value();
+      peer_timestamps_ = seg.sender_message.tsval.has_value();
+      if ( cfg_.window_scaling and peer_window_scaling_ ) {
+        receiver_.set_window_shift( cfg_.window_shift() );
+      }
+    }
+
+    // Give incoming TCPReceiverMessage to sender (a segment with data of its own is no duplicate ACK).
+    sender_.receive( seg.receiver_message, seg.sender_message.sequence_length() > 0 );
 
     // Give incoming TCPSenderMessage to receiver.
     // If SenderMessage is non-empty or a keep-alive, make sure to reply.
@@ -61,8 +95,9 @@ public:
 
   std::optional<TCPSegment> maybe_send()
   {
-    // Get outgoing TCPReceiverMessage from receiver.
-    auto receiver_msg = receiver_.send( inbound_stream_.writer() );
+    // Get outgoing TCPReceiverMessage from receiver (with SACK blocks if both sides offered SACK).
+    auto receiver_msg = sending_sack_() ? receiver_.send( inbound_stream_.writer(), reassembler_ )
+                                        : receiver_.send( inbound_stream_.writer() );
 
     // If connection is alive, push stream to TCPSender.
     if ( receiver_msg.ackno.has_value() ) {
@@ -78,8 +113,35 @@ public:
 
     need_send_ = false;
 
-    // Send the segment
+    // Send the segment, offering SACK and announcing our MSS along with our SYN. Window scaling is offered
+    // first, or in reply to the peer's offer; and the window in a SYN is never scaled.
     if ( sender_msg.has_value() ) {
+      receiver_msg.sack_permitted = cfg_.sack and sender_msg->SYN;
+      if ( sender_msg->SYN ) {
+        receiver_msg.mss = cfg_.mss;
+        if ( cfg_.window_scaling and ( not receiver_msg.ackno.has_value() or peer_window_scaling_ ) ) {
+          receiver_msg.window_scale = cfg_.window_shift();
+        }
+        const uint64_t window = inbound_stream_.writer().available_capacity();
+        receiver_msg.window_size = static_cast<uint16_t>( std::min<uint64_t>( window, UINT16_MAX ) );
+      }
+
+      // Timestamps likewise: offered on our SYN first or in reply, and on every segment once both SYNs had them
+      const bool offering = sender_msg->SYN and not receiver_msg.ackno.has_value();
+      if ( not cfg_.timestamps or not( offering or peer_timestamps_ ) ) {
+        sender_msg->tsval.reset();
+        receiver_msg.tsecr.reset();
+      }
+      // a segment sized before more holes opened up reports only the (most recent) SACK blocks that fit
+      if ( not sender_msg->SYN ) {
+        const bool timestamps = sender_msg->tsval.has_value();
+        while ( not receiver_msg.sack_blocks.empty()
+                and sender_msg->payload.size()
+                        + TCPSegment::data_options_length( timestamps, receiver_msg.sack_blocks.size() )
+                      > sender_.mss() ) {
+          receiver_msg.sack_blocks.pop_back();
+        }
+      }
       return TCPSegment {
         sender_msg.value(), receiver_msg, outbound_stream_.reader().has_error() or inbound_reader().has_error() };
     }
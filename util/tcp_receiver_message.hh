@@ -2,12 +2,14 @@
 
 #include "wrapping_integers.hh"
 
+#include <cstddef>
 #include <optional>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains two fields:
+ * It contains two fields, and five optional ones:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
@@ -15,12 +17,40 @@
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
  *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
  *    the <cstdint> header).
+ *
+ * 3) SACK blocks (RFC 2018): sequence numbers the receiver holds beyond the ackno, so the sender
+ *    can tell which segments are missing. Each block runs from its left edge up to (not including)
+ *    its right edge. Only sent to a peer that offered SACK, and at most MAX_SACK_BLOCKS of them.
+ *
+ * 4) The SACK-permitted flag: sent along with a SYN to offer SACK to the peer.
+ *
+ * 5) The MSS: sent along with a SYN, the largest payload the receiver wants in a segment.
+ *
+ * 6) The window scale (RFC 7323): sent along with a SYN, the shift the receiver will apply to the windows
+ *    it advertises once both SYNs have carried one. The window_size field itself stays 16 bits.
+ *
+ * 7) The timestamp echo (TSecr, RFC 7323): the latest in-sequence TSval received from the sender.
  */
 
+struct SACKBlock
+{
+  Wrap32 left_edge;
+  Wrap32 right_edge;
+
+  bool operator==( const SACKBlock& other ) const = default;
+};
+
 struct TCPReceiverMessage
 {
+  static constexpr size_t MAX_SACK_BLOCKS = 4; // as many as fit in the TCP header's option space
+
   std::optional<Wrap32> ackno {};
   uint16_t window_size {};
+  std::vector<SACKBlock> sack_blocks {};
+  bool sack_permitted {};
+  std::optional<uint16_t> mss {};
+  std::optional<uint8_t> window_scale {};
+  std::optional<uint32_t> tsecr {};
 
   TCPReceiverMessage( std::optional<Wrap32> _ackno, uint16_t _window_size );
 };
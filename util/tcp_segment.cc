@@ -2,12 +2,211 @@
 #include "checksum.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
 
-static constexpr uint32_t TCPHeaderMinLen = 5; // 32-bit words
+static constexpr uint32_t TCPHeaderMinLen = 5;  // 32-bit words
+static constexpr uint32_t TCPOptionsMaxLen = 40; // bytes
+
+// TCP option kinds
+static constexpr uint8_t TCPOptionEnd = 0;
+static constexpr uint8_t TCPOptionNop = 1;
+static constexpr uint8_t TCPOptionMSS = 2;           // RFC 9293
+static constexpr uint8_t TCPOptionWindowScale = 3;   // RFC 7323
+static constexpr uint8_t TCPOptionSACKPermitted = 4; // RFC 2018
+static constexpr uint8_t TCPOptionSACK = 5;          // RFC 2018
+static constexpr uint8_t TCPOptionTimestamps = 8;    // RFC 7323
+
+static constexpr uint8_t TCPOptionMSSLen = 4;
+static constexpr uint8_t TCPOptionWindowScaleLen = 3;
+static constexpr uint8_t TCPOptionSACKPermittedLen = 2;
+static constexpr uint8_t TCPOptionSACKBlockLen = 8;
+static constexpr uint8_t TCPOptionTimestampsLen = 10;
 
 using namespace std;
 
+class Wrap32Serializable : public Wrap32
+{
+public:
+  uint32_t raw_value() const { return raw_value_; }
+};
+
+void TCPSegment::parse_options( Parser& parser, uint32_t options_len )
+{
+  while ( options_len > 0 and not parser.has_error() ) {
+    uint8_t kind {};
+    parser.integer( kind );
+    options_len--;
+
+    if ( kind == TCPOptionEnd ) {
+      parser.remove_prefix( options_len ); // the rest is padding
+      return;
+    }
+    if ( kind == TCPOptionNop ) {
+      continue;
+    }
+
+    uint8_t len {};
+    parser.integer( len );
+    if ( options_len == 0 or len < 2 or len - 1U > options_len ) {
+      parser.set_error();
+      return;
+    }
+    options_len -= len - 1;
+
+    switch ( kind ) {
+      case TCPOptionMSS: {
+        if ( len != TCPOptionMSSLen ) {
+          parser.set_error();
+          return;
+        }
+        uint16_t mss {};
+        parser.integer( mss );
+        receiver_message.mss = mss;
+        break;
+      }
+
+      case TCPOptionWindowScale: {
+        if ( len != TCPOptionWindowScaleLen ) {
+          parser.set_error();
+          return;
+        }
+        uint8_t shift {};
+        parser.integer( shift );
+        receiver_message.window_scale = shift;
+        break;
+      }
+
+      case TCPOptionTimestamps: {
+        if ( len != TCPOptionTimestampsLen ) {
+          parser.set_error();
+          return;
+        }
+        uint32_t tsval {};
+        uint32_t tsecr {};
+        parser.integer( tsval );
+        parser.integer( tsecr );
+        sender_message.tsval = tsval;
+        if ( receiver_message.ackno.has_value() ) { // the echo means nothing without an ACK
+          receiver_message.tsecr = tsecr;
+        }
+        break;
+      }
+
+      case TCPOptionSACKPermitted:
+        receiver_message.sack_permitted = true;
+        parser.remove_prefix( len - 2 );
+        break;
+
+      case TCPOptionSACK:
+        if ( ( len - 2 ) % TCPOptionSACKBlockLen ) {
+          parser.set_error();
+          return;
+        }
+        receiver_message.sack_blocks.clear();
+        for ( uint8_t i = 0; i < ( len - 2 ) / TCPOptionSACKBlockLen; i++ ) {
+          uint32_t left_edge {};
+          uint32_t right_edge {};
+          parser.integer( left_edge );
+          parser.integer( right_edge );
+          receiver_message.sack_blocks.push_back( { Wrap32 { left_edge }, Wrap32 { right_edge } } );
+        }
+        break;
+
+      default: // skip options we don't know
+        parser.remove_prefix( len - 2 );
+        break;
+    }
+  }
+}
+
+uint32_t TCPSegment::syn_options_length() const
+{
+  if ( not sender_message.SYN ) {
+    return 0;
+  }
+  return ( receiver_message.mss.has_value() ? TCPOptionMSSLen : 0 )
+         + ( receiver_message.window_scale.has_value() ? TCPOptionWindowScaleLen : 0 )
+         + ( receiver_message.sack_permitted ? TCPOptionSACKPermittedLen : 0 );
+}
+
+size_t TCPSegment::sack_blocks_to_send() const
+{
+  if ( not receiver_message.ackno.has_value() ) {
+    return 0;
+  }
+
+  const size_t space
+    = TCPOptionsMaxLen - syn_options_length() - ( sender_message.tsval.has_value() ? TCPOptionTimestampsLen : 0 );
+  const size_t max_blocks = ( space - 2 ) / TCPOptionSACKBlockLen;
+  return min( { receiver_message.sack_blocks.size(), max_blocks, TCPReceiverMessage::MAX_SACK_BLOCKS } );
+}
+
+uint32_t TCPSegment::options_length() const
+{
+  uint32_t len = syn_options_length();
+  if ( sender_message.tsval.has_value() ) {
+    len += TCPOptionTimestampsLen;
+  }
+  if ( const size_t blocks = sack_blocks_to_send() ) {
+    len += 2 + blocks * TCPOptionSACKBlockLen;
+  }
+  return ( len + 3 ) / 4 * 4; // padded to whole 32-bit words
+}
+
+uint32_t TCPSegment::data_options_length( bool timestamps, size_t sack_blocks )
+{
+  const uint32_t timestamps_len = timestamps ? TCPOptionTimestampsLen : 0;
+  const size_t max_blocks = ( TCPOptionsMaxLen - timestamps_len - 2 ) / TCPOptionSACKBlockLen;
+  const size_t blocks = min( { sack_blocks, max_blocks, TCPReceiverMessage::MAX_SACK_BLOCKS } );
+  const uint32_t len = timestamps_len + ( blocks > 0 ? 2 + blocks * TCPOptionSACKBlockLen : 0 );
+  return ( len + 3 ) / 4 * 4;
+}
+
+void TCPSegment::serialize_options( Serializer& serializer ) const
+{
+  uint32_t len = 0;
+  if ( sender_message.SYN and receiver_message.mss.has_value() ) {
+    serializer.integer( TCPOptionMSS );
+    serializer.integer( TCPOptionMSSLen );
+    serializer.integer( receiver_message.mss.value() );
+    len += TCPOptionMSSLen;
+  }
+  if ( sender_message.SYN and receiver_message.window_scale.has_value() ) {
+    serializer.integer( TCPOptionWindowScale );
+    serializer.integer( TCPOptionWindowScaleLen );
+    serializer.integer( receiver_message.window_scale.value() );
+    len += TCPOptionWindowScaleLen;
+  }
+  if ( sender_message.SYN and receiver_message.sack_permitted ) {
+    serializer.integer( TCPOptionSACKPermitted );
+    serializer.integer( TCPOptionSACKPermittedLen );
+    len += TCPOptionSACKPermittedLen;
+  }
+
+  if ( sender_message.tsval.has_value() ) {
+    serializer.integer( TCPOptionTimestamps );
+    serializer.integer( TCPOptionTimestampsLen );
+    serializer.integer( sender_message.tsval.value() );
+    serializer.integer( receiver_message.ackno.has_value() ? receiver_message.tsecr.value_or( 0 ) : 0 );
+    len += TCPOptionTimestampsLen;
+  }
+
+  if ( const size_t blocks = sack_blocks_to_send() ) {
+    serializer.integer( TCPOptionSACK );
+    serializer.integer( static_cast<uint8_t>( 2 + blocks * TCPOptionSACKBlockLen ) );
+    for ( size_t i = 0; i < blocks; i++ ) {
+      serializer.integer( Wrap32Serializable { receiver_message.sack_blocks[i].left_edge }.raw_value() );
+      serializer.integer( Wrap32Serializable { receiver_message.sack_blocks[i].right_edge }.raw_value() );
+    }
+    len += 2 + blocks * TCPOptionSACKBlockLen;
+  }
+
+  for ( ; len < options_length(); len++ ) {
+    serializer.integer( TCPOptionEnd );
+  }
+}
+
 void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum )
 {
   {
@@ -52,34 +251,29 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
   parser.integer( udinfo.cksum );
   parser.integer( raw16 ); // urgent pointer
 
-  // skip any options or anything extra in the header
   if ( data_offset < TCPHeaderMinLen ) {
     parser.set_error();
+    return;
   }
-  parser.remove_prefix( data_offset * 4 - TCPHeaderMinLen * 4 );
+  parse_options( parser, data_offset * 4 - TCPHeaderMinLen * 4 );
 
   parser.all_remaining( sender_message.payload );
 }
 
-class Wrap32Serializable : public Wrap32
-{
-public:
-  uint32_t raw_value() const { return raw_value_; }
-};
-
 void TCPSegment::serialize( Serializer& serializer ) const
 {
   serializer.integer( udinfo.src_port );
   serializer.integer( udinfo.dst_port );
   serializer.integer( Wrap32Serializable { sender_message.seqno }.raw_value() );
   serializer.integer( Wrap32Serializable { receiver_message.ackno.value_or( Wrap32 { 0 } ) }.raw_value() );
-  serializer.integer( uint8_t { TCPHeaderMinLen << 4 } ); // data offset
+  serializer.integer( static_cast<uint8_t>( ( TCPHeaderMinLen + options_length() / 4 ) << 4 ) ); // data offset
   const uint8_t flags = ( receiver_message.ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
                         | ( sender_message.SYN ? 0b0000'0010U : 0 ) | ( sender_message.FIN ? 0b0000'0001U : 0 );
   serializer.integer( flags );
   serializer.integer( receiver_message.window_size );
   serializer.integer( udinfo.cksum );
   serializer.integer( uint16_t { 0 } ); // urgent pointer
+  serialize_options( serializer );
   serializer.buffer( sender_message.payload );
 }
 
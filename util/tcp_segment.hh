@@ -16,4 +16,16 @@ struct TCPSegment
   void serialize( Serializer& serializer ) const;
 
   void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
+
+  // The options on a segment other than a SYN, with timestamps or not and up to `sack_blocks` SACK blocks
+  // (as many as fit): in bytes, including padding
+  static uint32_t data_options_length( bool timestamps, size_t sack_blocks );
+
+private:
+  // TCP options: MSS, window scale and SACK-permitted (on a SYN), timestamps, and SACK blocks (with an ackno)
+  void parse_options( Parser& parser, uint32_t options_len );
+  void serialize_options( Serializer& serializer ) const;
+  uint32_t syn_options_length() const; // in bytes, unpadded
+  size_t sack_blocks_to_send() const;
+  uint32_t options_length() const; // in bytes, including padding
 };